@@ -1,4 +1,12 @@
 #include "base.h"
+#include "base_telemetry.c"
 #include "base_arena.c"
 #include "base_pool.c"
-#include "base_hashtable.c"
\ No newline at end of file
+#include "base_alloc.c"
+#include "base_array.c"
+#include "base_hash.c"
+#include "base_hashtable.c"
+#include "base_perfect_hash.c"
+#include "base_file.c"
+#include "base_profile.c"
+#include "base_job.c"
\ No newline at end of file
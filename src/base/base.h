@@ -13,12 +13,93 @@ void*   nb_align_pointer(void* ptr, usize align);
 void*   nb_aligned_allocate(usize size, usize align);
 void    nb_aligned_free(void* ptr, usize size, usize align);
 
+// Telemetry ---------------------------------------------------
+
+typedef enum {
+    MEMORY_TAG_UNTAGGED,
+    MEMORY_TAG_POOL,
+    MEMORY_TAG_HASHTABLE,
+    MEMORY_TAG_SCRATCH,
+    MEMORY_TAG_SCENE,
+    MEMORY_TAG_GEOMETRY,
+    MEMORY_TAG_BVH,
+    MEMORY_TAG_TEXTURE,
+    MEMORY_TAG_RENDER,
+    MEMORY_TAG_COUNT,
+} MemoryTag;
+
+// Bucket 0 holds sizes up to 16 bytes, each next bucket doubles that and
+// the last one holds everything bigger
+#define NB_TELEMETRY_HISTOGRAM_BUCKETS 16
+
+typedef struct MemoryTagStats {
+    u64 alloc_count;
+    u64 bytes;
+    u64 padding;        // Bytes lost to alignment
+    u64 histogram[NB_TELEMETRY_HISTOGRAM_BUCKETS];
+} MemoryTagStats;
+
+typedef struct MemoryTelemetry {
+    MemoryTagStats tags[MEMORY_TAG_COUNT];
+} MemoryTelemetry;
+
+// Allocations made between BEGIN/END on this thread are recorded under 'tag'.
+// BEGIN returns the tag it replaced, hand it back to END so scopes nest:
+//     MemoryTag previous = NB_MEMORY_TAG_BEGIN(MEMORY_TAG_BVH);
+//     ...
+//     NB_MEMORY_TAG_END(previous);
+#ifdef NB_TELEMETRY_ENABLED
+#define NB_MEMORY_TAG_BEGIN(tag) nb_memory_tag_set(tag)
+#define NB_MEMORY_TAG_END(previous) nb_memory_tag_set(previous)
+
+MemoryTag   nb_memory_tag_set(MemoryTag tag);
+const char* nb_memory_tag_name(MemoryTag tag);
+void        nb_telemetry_report(MemoryTelemetry* telemetry, const char* name);
+// Writes a JSON object into buffer, returns the length it needed
+usize       nb_telemetry_json(MemoryTelemetry* telemetry, const char* name, char* buffer, usize size);
+#else
+#define NB_MEMORY_TAG_BEGIN(tag) ((void)(tag), MEMORY_TAG_UNTAGGED)
+#define NB_MEMORY_TAG_END(previous) ((void)(previous))
+#endif
+
 // Arena Allocator --------------------------------------------
 
 typedef struct Arena Arena;
 
+#define NB_ARENA_DEFAULT_COMMIT_GRANULARITY (64 * 1024)
+
+typedef enum {
+    ARENA_FLAG_NONE         = 0,
+    // Reserve the whole range up front but only commit pages as the marker reaches them
+    ARENA_FLAG_GROWABLE     = 1 << 0,
+    // nb_arena_clear/nb_arena_free_to_marker decommit pages past max(marker, decommit_retain)
+    ARENA_FLAG_DECOMMIT     = 1 << 1,
+    // Link a new block (from the parent or the platform) instead of failing when full
+    ARENA_FLAG_CHAINED      = 1 << 2,
+    // Prefer numa_node for the pages of platform allocated blocks
+    ARENA_FLAG_NUMA_BIND    = 1 << 3,
+} ArenaFlags;
+
+typedef struct ArenaParams {
+    usize reserve_size;         // Max size of the arena buffer
+    usize commit_size;          // Bytes committed at creation (growable arenas only)
+    usize commit_granularity;   // Commit step, rounded up to the page size, 0 uses the default
+    usize decommit_retain;      // High-water mark kept committed when decommitting
+    usize block_size;           // Size of blocks linked by chained arenas, defaults to reserve_size
+    u32   flags;                // ArenaFlags
+    u32   memory_flags;         // PlatformMemoryFlags used to reserve/commit platform blocks
+    u32   numa_node;            // Node used with ARENA_FLAG_NUMA_BIND
+} ArenaParams;
+
 // If parent arena is null this will use platform's allocator
 Arena*      nb_arena_create(Arena* parent, usize size);
+Arena*      nb_arena_create_growable(usize reserve_size, usize commit_granularity);
+Arena*      nb_arena_create_chained(Arena* parent, usize block_size);
+// Growable arena whose pages are placed on 'node', falls back to first touch
+// where the platform can't bind an existing reservation
+Arena*      nb_arena_create_on_node(usize reserve_size, usize commit_granularity, u32 node);
+// Growable and decommit flags are ignored for arenas created inside a parent
+Arena*      nb_arena_create_with_params(Arena* parent, const ArenaParams* params);
 
 // This is safe to call on non platform allocated arenas
 void        nb_arena_destroy(Arena* arena);
@@ -26,11 +107,46 @@ void        nb_arena_destroy(Arena* arena);
 void*       nb_arena_alloc(Arena* arena, usize size);
 void*       nb_arena_alloc_aligned(Arena* arena, usize size, usize align);
 void        nb_arena_clear(Arena* arena);
+// Markers stay valid across the blocks of a chained arena
 usize       nb_arena_get_marker(Arena* arena);
 void        nb_arena_free_to_marker(Arena* arena, usize marker);
 
 usize       nb_arena_used_memory(Arena* arena);
 usize       nb_arena_peak_memory(Arena* arena);
+usize       nb_arena_committed_memory(Arena* arena);
+
+#ifdef NB_TELEMETRY_ENABLED
+MemoryTelemetry* nb_arena_telemetry(Arena* arena);
+#else
+#define nb_arena_telemetry(arena) ((MemoryTelemetry*)null)
+#endif
+
+// Temporary Arena ------------------------------------------------------
+
+typedef struct TempArena {
+    Arena* arena;
+    usize  marker;
+} TempArena;
+
+TempArena   nb_temp_arena_begin(Arena* arena);
+void        nb_temp_arena_end(TempArena temp);
+
+// Scratch Arenas -------------------------------------------------------
+
+#define NB_SCRATCH_ARENA_COUNT 2
+#if defined(NB_ARCH_X64) || defined(NB_ARCH_ARM64)
+#define NB_SCRATCH_ARENA_RESERVE_SIZE ((usize)8 * 1024 * 1024 * 1024)
+#else
+#define NB_SCRATCH_ARENA_RESERVE_SIZE ((usize)256 * 1024 * 1024)
+#endif
+
+// Returns a scope on this thread's scratch arena that isn't any of 'conflicts'.
+// Pass the arenas the caller is allocating its results from so temporaries
+// never get freed from under them.
+TempArena   nb_scratch_begin(Arena** conflicts, usize conflict_count);
+void        nb_scratch_end(TempArena temp);
+// Releases the calling thread's scratch arenas, call before a thread exits
+void        nb_scratch_release_thread(void);
 
 // Pool Allocator ------------------------------------------------------
 
@@ -38,22 +154,205 @@ typedef struct Pool Pool;
 
 Pool*       nb_pool_create(Arena *a, usize size, usize count);
 Pool*       nb_pool_create_aligned(Arena *a, usize size, usize count, usize align);
+// Growable pools add chunks of 'chunk_count' objects from the arena when empty
+Pool*       nb_pool_create_growable(Arena *a, usize size, usize chunk_count);
+Pool*       nb_pool_create_growable_aligned(Arena *a, usize size, usize chunk_count, usize align);
 
 void*       nb_pool_alloc(Pool* pool);  
 void        nb_pool_free(Pool* pool, void* ptr);
 
 usize       nb_pool_used_memory(Pool* pool);
 usize       nb_pool_peak_memory(Pool* pool);
+usize       nb_pool_capacity(Pool* pool);
+
+#ifdef NB_TELEMETRY_ENABLED
+MemoryTelemetry* nb_pool_telemetry(Pool* pool);
+#else
+#define nb_pool_telemetry(pool) ((MemoryTelemetry*)null)
+#endif
+
+// Concurrent Pool -----------------------------------------------------
+
+// Lock free fixed capacity pool. Each thread caches slots in a magazine and
+// moves them to and from the shared free list in batches, so most
+// alloc/free calls touch no shared state. Used/peak memory counts slots
+// held by magazines as used. Calls mirror nb_pool_*, Pool stays a separate
+// single threaded type so it doesn't pay for atomics and magazines.
+typedef struct ConcurrentPool ConcurrentPool;
+
+#define NB_POOL_MAGAZINE_BATCH      32
+#define NB_POOL_MAGAZINE_CAPACITY   (NB_POOL_MAGAZINE_BATCH * 2)
+#define NB_POOL_MAGAZINE_SLOTS      8
+// Pools alive at the same time
+#define NB_CONCURRENT_POOL_MAX_COUNT 1024
+
+// Returns null when NB_CONCURRENT_POOL_MAX_COUNT pools are alive
+ConcurrentPool* nb_concurrent_pool_create(Arena *a, usize size, usize count);
+ConcurrentPool* nb_concurrent_pool_create_aligned(Arena *a, usize size, usize count, usize align);
+// Call before freeing the pool's memory, no thread may be inside a call on
+// it. Slots other threads still cache are dropped instead of returned.
+void            nb_concurrent_pool_destroy(ConcurrentPool* pool);
+
+void*           nb_concurrent_pool_alloc(ConcurrentPool* pool);
+void            nb_concurrent_pool_free(ConcurrentPool* pool, void* ptr);
+
+// Returns the calling thread's cached slots to their pools, call before a
+// thread exits
+void            nb_concurrent_pool_release_thread(void);
+
+usize           nb_concurrent_pool_used_memory(ConcurrentPool* pool);
+usize           nb_concurrent_pool_peak_memory(ConcurrentPool* pool);
+
+// General Allocator ---------------------------------------------------
+
+// Power of two size classes from 16 bytes to 32KiB, each backed by a growable
+// pool. Bigger requests reserve their own pages. Thread safe, memory is
+// aligned to min(class size, NB_DEFAULT_ALIGNMENT).
+
+#define NB_ALLOC_MIN_SIZE       16
+#define NB_ALLOC_CLASS_COUNT    12
+#define NB_ALLOC_MAX_SIZE       (NB_ALLOC_MIN_SIZE << (NB_ALLOC_CLASS_COUNT - 1))
+#define NB_ALLOC_CHUNK_SIZE     (64 * 1024)
+#if defined(NB_ARCH_X64) || defined(NB_ARCH_ARM64)
+#define NB_ALLOC_CLASS_RESERVE_SIZE ((usize)4 * 1024 * 1024 * 1024)
+#else
+#define NB_ALLOC_CLASS_RESERVE_SIZE ((usize)64 * 1024 * 1024)
+#endif
+
+void*       nb_alloc(usize size);
+void        nb_free(void* ptr);
+void*       nb_realloc(void* ptr, usize size);
+char*       nb_strdup(const char* str);
+
+typedef struct AllocatorStats {
+    usize object_size;  // 0 for large allocations
+    usize alloc_count;
+    usize used_memory;
+    usize peak_memory;
+} AllocatorStats;
+
+usize       nb_alloc_class_size(usize class_index);
+// class_index NB_ALLOC_CLASS_COUNT reports large allocations
+void        nb_alloc_get_stats(usize class_index, AllocatorStats* stats);
+
+// Virtual Array -------------------------------------------------------
+
+// Growable array over a reserved address range. Pages are committed as the
+// array grows so elements never move and pointers to them stay valid.
+
+#define NB_VARRAY_COMMIT_SIZE (64 * 1024)
+
+typedef struct VirtualArray {
+    u8*   data;
+    usize count;
+    usize capacity;     // Elements backed by committed memory
+    usize max_count;    // Elements the reservation can hold
+    usize item_size;
+} VirtualArray;
+
+// Returns false when the reservation fails or item_size * max_count overflows
+b32         nb_varray_create(VirtualArray* array, usize item_size, usize max_count);
+void        nb_varray_destroy(VirtualArray* array);
+// Returns the first of 'count' new uninitialized elements, null past max_count
+void*       nb_varray_push(VirtualArray* array, usize count);
+void        nb_varray_pop(VirtualArray* array, usize count);
+void        nb_varray_clear(VirtualArray* array);
+
+// Generates a typed wrapper, e.g. NB_VARRAY_DEFINE(HitArray, hit_array, Hit)
+// gives HitArray with .data/.count and hit_array_create/push/... functions.
+#define NB_VARRAY_DEFINE(Name, prefix, T)                                          \
+    typedef union Name {                                                           \
+        VirtualArray base;                                                         \
+        struct {                                                                   \
+            T* data;                                                               \
+            usize count;                                                           \
+        };                                                                         \
+    } Name;                                                                        \
+                                                                                   \
+    internal NB_FORCE_INLINE b32 prefix##_create(Name* array, usize max_count) {   \
+        return nb_varray_create(&array->base, sizeof(T), max_count);               \
+    }                                                                              \
+    internal NB_FORCE_INLINE void prefix##_destroy(Name* array) {                  \
+        nb_varray_destroy(&array->base);                                           \
+    }                                                                              \
+    internal NB_FORCE_INLINE T* prefix##_push(Name* array, T value) {              \
+        T* item;                                                                   \
+        if (array->base.count < array->base.capacity) {                            \
+            item = array->data + array->base.count++;                              \
+        } else {                                                                   \
+            item = (T*)nb_varray_push(&array->base, 1);                            \
+            if (item == null) {                                                    \
+                return null;                                                       \
+            }                                                                      \
+        }                                                                          \
+        *item = value;                                                             \
+        return item;                                                               \
+    }                                                                              \
+    internal NB_FORCE_INLINE T* prefix##_push_n(Name* array, usize count) {        \
+        return (T*)nb_varray_push(&array->base, count);                            \
+    }                                                                              \
+    internal NB_FORCE_INLINE T prefix##_pop(Name* array) {                         \
+        NB_ASSERT(array->base.count > 0);                                          \
+        return array->data[--array->base.count];                                   \
+    }                                                                              \
+    internal NB_FORCE_INLINE void prefix##_clear(Name* array) {                    \
+        nb_varray_clear(&array->base);                                             \
+    }                                                                              \
+    internal NB_FORCE_INLINE T* prefix##_at(Name* array, usize index) {            \
+        NB_ASSERT(index < array->base.count);                                      \
+        return array->data + index;                                                \
+    }
+
+// Hashing -------------------------------------------------------------
+
+// wyhash, reads 8 bytes at a time and has good low bits. Values are stable
+// across builds so they can be stored.
+u64         nb_hash_bytes(const void* data, usize length, u64 seed);
+u64         nb_hash_string(const char* str);
+// Integer mixer, every input bit affects every output bit
+u64         nb_hash_u64(u64 value);
 
 // Hashtable -----------------------------------------------------------
 
 typedef struct Hashtable Hashtable;
 
+// Tables created with a null arena live on nb_alloc and own their keys,
+// the arena passed to nb_hashtable_set is ignored for them
 Hashtable*  nb_hashtable_create(Arena* arena);
+// Spreads each resize over the following inserts instead of rehashing at once
+Hashtable*  nb_hashtable_create_incremental(Arena* arena);
+// Starts large enough for 'count' entries so loading them never resizes
+Hashtable*  nb_hashtable_create_with_capacity(Arena* arena, usize count);
+// Frees tables created without an arena, safe to call on arena tables
+void        nb_hashtable_destroy(Hashtable* ht);
 void*       nb_hashtable_get(Hashtable* ht, const char* key);
+// For keys that aren't NUL-terminated or whose length is already known
+void*       nb_hashtable_get_n(Hashtable* ht, const char* key, usize length);
+// New keys and grown arrays come from 'arena', the returned key lives as long as it does
 const char* nb_hashtable_set(Hashtable* ht, Arena* arena, const char* key, void* value);
+// Grows once so the table holds 'count' entries without resizing again
+b32         nb_hashtable_reserve(Hashtable* ht, Arena* arena, usize count);
+// Inserts or updates keys[i] -> values[i], reserving room for them all up
+// front. Returns the number of pairs stored, less than 'count' only if an
+// allocation failed. Runs on the calling thread: inserts into one table
+// can't be split across job workers without locking the arrays, so for
+// very large loads build per-thread tables and merge them instead.
+usize       nb_hashtable_set_many(Hashtable* ht, Arena* arena, const char** keys, void** values, usize count);
+b32         nb_hashtable_remove(Hashtable* ht, const char* key);
+b32         nb_hashtable_remove_n(Hashtable* ht, const char* key, usize length);
 usize       nb_hashtable_length(Hashtable *ht);
 
+typedef struct HashtableStats {
+    usize length;
+    usize capacity;
+    usize tombstones;           // DELETED slots left by removals
+    usize max_probe_length;     // In groups of 16 slots, 1 = found in the first group
+    f64   average_probe_length;
+} HashtableStats;
+
+// Walks every entry, meant for tuning rather than hot paths
+void        nb_hashtable_stats(Hashtable* ht, HashtableStats* stats);
+
 typedef struct HashtableIterator {
     const char* key;
     void* value;
@@ -64,6 +363,226 @@ typedef struct HashtableIterator {
 HashtableIterator   nb_hashtable_iterator(Hashtable *ht);
 b8                  nb_hashtable_next(HashtableIterator *hti);
 
+// Integer Hashtable ---------------------------------------------------
+
+// Keys are stored inline and compared directly. Like Hashtable, a null
+// arena puts the table on nb_alloc and values can't be null.
+typedef struct IntHashtable IntHashtable;
+
+IntHashtable*   nb_int_hashtable_create(Arena* arena);
+void            nb_int_hashtable_destroy(IntHashtable* ht);
+void*           nb_int_hashtable_get(IntHashtable* ht, u64 key);
+b32             nb_int_hashtable_set(IntHashtable* ht, Arena* arena, u64 key, void* value);
+b32             nb_int_hashtable_remove(IntHashtable* ht, u64 key);
+usize           nb_int_hashtable_length(IntHashtable* ht);
+void            nb_int_hashtable_stats(IntHashtable* ht, HashtableStats* stats);
+
+// Generates a table typed on key K, 'to_key' converts K to the u64 key
+#define NB_INT_HASHTABLE_DEFINE(Name, prefix, K, to_key)                           \
+    typedef struct Name Name;                                                      \
+                                                                                   \
+    internal NB_FORCE_INLINE Name* prefix##_create(Arena* arena) {                 \
+        return (Name*)nb_int_hashtable_create(arena);                              \
+    }                                                                              \
+    internal NB_FORCE_INLINE void prefix##_destroy(Name* ht) {                     \
+        nb_int_hashtable_destroy((IntHashtable*)ht);                               \
+    }                                                                              \
+    internal NB_FORCE_INLINE void* prefix##_get(Name* ht, K key) {                 \
+        return nb_int_hashtable_get((IntHashtable*)ht, to_key(key));               \
+    }                                                                              \
+    internal NB_FORCE_INLINE b32 prefix##_set(Name* ht, Arena* arena, K key,       \
+                                              void* value) {                       \
+        return nb_int_hashtable_set((IntHashtable*)ht, arena, to_key(key),         \
+                                    value);                                        \
+    }                                                                              \
+    internal NB_FORCE_INLINE b32 prefix##_remove(Name* ht, K key) {                \
+        return nb_int_hashtable_remove((IntHashtable*)ht, to_key(key));            \
+    }                                                                              \
+    internal NB_FORCE_INLINE usize prefix##_length(Name* ht) {                     \
+        return nb_int_hashtable_length((IntHashtable*)ht);                         \
+    }
+
+#define NB_HASHTABLE_INT_KEY(key) ((u64)(key))
+#define NB_HASHTABLE_PTR_KEY(key) ((u64)(uptr)(key))
+
+NB_INT_HASHTABLE_DEFINE(HashtableU32, nb_hashtable_u32, u32, NB_HASHTABLE_INT_KEY)
+NB_INT_HASHTABLE_DEFINE(HashtableU64, nb_hashtable_u64, u64, NB_HASHTABLE_INT_KEY)
+NB_INT_HASHTABLE_DEFINE(HashtablePtr, nb_hashtable_ptr, const void*, NB_HASHTABLE_PTR_KEY)
+
+// Concurrent Hashtable ------------------------------------------------
+
+// String keyed table for read-mostly data shared between threads. Lookups
+// take no lock and finish in a bounded number of steps, writers are
+// serialized by a spin lock. Arrays replaced by a resize are retired rather
+// than freed since readers may still be probing them, call
+// nb_concurrent_hashtable_reclaim at a point where no thread is inside a
+// lookup (e.g. between frames) to free them. Memory comes from nb_alloc and
+// keys are copied, entries can't be removed.
+typedef struct ConcurrentHashtable ConcurrentHashtable;
+
+ConcurrentHashtable*    nb_concurrent_hashtable_create(void);
+// No other thread may be using the table
+void                    nb_concurrent_hashtable_destroy(ConcurrentHashtable* ht);
+void*                   nb_concurrent_hashtable_get(ConcurrentHashtable* ht, const char* key);
+void*                   nb_concurrent_hashtable_get_n(ConcurrentHashtable* ht, const char* key, usize length);
+// Replaces the value of an existing key, returns the stored key or null if out of memory
+const char*             nb_concurrent_hashtable_set(ConcurrentHashtable* ht, const char* key, void* value);
+usize                   nb_concurrent_hashtable_length(ConcurrentHashtable* ht);
+// Frees retired arrays, returns the number of bytes released
+usize                   nb_concurrent_hashtable_reclaim(ConcurrentHashtable* ht);
+
+// Perfect Hashtable ---------------------------------------------------
+
+// Immutable minimal perfect hash table stored as one position independent
+// blob: a header, one u32 displacement per bucket, a slot per key and a
+// string pool the slots point into by offset. It can be written to a file
+// as is and queried straight from the loaded or mapped bytes. Values are
+// u64 so they survive being stored, the blob uses the native byte order.
+typedef struct PerfectHashtable PerfectHashtable;
+
+#define NB_PERFECT_HASHTABLE_MAGIC      0x4850424Eu // "NBPH"
+#define NB_PERFECT_HASHTABLE_VERSION    1
+
+// Converts a Hashtable value to the stored u64, e.g. an index into an asset array
+typedef u64 (*PerfectHashtableValueFn)(const char* key, void* value, void* user_data);
+
+// Builds the blob from 'ht' into 'arena', a null 'to_value' stores the
+// pointer bits. Returns the blob (8 byte aligned) and its size, null on failure.
+void*               nb_perfect_hashtable_build(
+                        Hashtable* ht, 
+                        Arena* arena, 
+                        PerfectHashtableValueFn to_value, 
+                        void* user_data, 
+                        usize* out_size);
+// Validates a blob in place without copying it, 'data' must be 8 byte aligned
+PerfectHashtable*   nb_perfect_hashtable_open(const void* data, usize size);
+b32                 nb_perfect_hashtable_get(PerfectHashtable* ph, const char* key, u64* out_value);
+b32                 nb_perfect_hashtable_get_n(PerfectHashtable* ph, const char* key, usize length, u64* out_value);
+usize               nb_perfect_hashtable_length(PerfectHashtable* ph);
+
+// Buffered File IO ----------------------------------------------------
+
+// Batches small reads and writes into large blocks so per-call costs are
+// paid once per block instead of once per call. Buffers are page aligned
+// and sized so files opened with PLATFORM_FILE_OPEN_DIRECT work, as long as
+// a writer's final block is a whole page. Transfers of a whole buffer or
+// more skip the copy when the caller's memory is page aligned.
+#define NB_FILE_BUFFER_DEFAULT_SIZE ((usize)1024 * 1024)
+
+typedef struct FileReader FileReader;
+typedef struct FileWriter FileWriter;
+
+// A buffer_size of 0 uses NB_FILE_BUFFER_DEFAULT_SIZE, the buffer comes from 'arena'
+FileReader* nb_file_reader_create(Arena* arena, PlatformFile* file, usize buffer_size);
+// Returns less than 'size' only at the end of the file or on an error
+usize       nb_file_reader_read(FileReader* reader, void* buffer, usize size);
+// Points at up to 'size' buffered bytes without copying, refilling if the
+// buffer is empty. Sets *out_size to the bytes available, 0 at the end.
+const void* nb_file_reader_peek(FileReader* reader, usize size, usize* out_size);
+void        nb_file_reader_skip(FileReader* reader, usize size);
+// Bytes consumed so far
+u64         nb_file_reader_position(FileReader* reader);
+
+FileWriter* nb_file_writer_create(Arena* arena, PlatformFile* file, usize buffer_size);
+// Returns false once any write to the file has failed
+b32         nb_file_writer_write(FileWriter* writer, const void* buffer, usize size);
+b32         nb_file_writer_flush(FileWriter* writer);
+// Bytes written so far, buffered ones included
+u64         nb_file_writer_position(FileWriter* writer);
+
+// Profiler ------------------------------------------------------------
+
+// Zones between BEGIN/END are timed with the CPU cycle counter and stored
+// in a per thread ring buffer, so only the most recent
+// NB_PROFILER_RING_CAPACITY zones of each thread are kept. Zones nest, a
+// zone's self time excludes the zones inside it. Names must outlive the
+// profiler, string literals are compared by address.
+#define NB_PROFILER_RING_CAPACITY   65536
+#define NB_PROFILER_MAX_THREADS     256
+#define NB_PROFILER_MAX_DEPTH       64
+
+typedef struct ProfileZoneStats {
+    const char* name;
+    u64 count;
+    f64 total_seconds;
+    f64 self_seconds;
+    f64 max_seconds;
+} ProfileZoneStats;
+
+#ifdef NB_PROFILER_ENABLED
+// Both must be in the same scope on the same thread
+#define NB_PROFILE_BEGIN(name) nb_profiler_begin(name)
+#define NB_PROFILE_END() nb_profiler_end()
+
+// Call once before any zone, thread ring buffers come from 'arena'
+void    nb_profiler_init(Arena* arena);
+void    nb_profiler_begin(const char* name);
+void    nb_profiler_end(void);
+// Shown as the thread's name in traces, the name is copied
+void    nb_profiler_set_thread_name(const char* name);
+// The functions below read every thread's ring, call them while no thread
+// is inside a zone (e.g. between frames)
+
+// Fills 'stats' sorted by total time, returns the number of distinct zones
+usize   nb_profiler_aggregate(ProfileZoneStats* stats, usize max);
+void    nb_profiler_report(void);
+// Chrome trace event JSON for chrome://tracing or ui.perfetto.dev,
+// returns the length it needed
+usize   nb_profiler_chrome_json(char* buffer, usize size);
+b32     nb_profiler_write_chrome_trace(const char* filepath);
+void    nb_profiler_reset(void);
+#else
+#define NB_PROFILE_BEGIN(name)
+#define NB_PROFILE_END()
+#endif
+
+// Job System ----------------------------------------------------------
+
+// Work stealing scheduler. Each worker pushes and pops its own jobs at the
+// bottom of a fixed size deque while idle workers steal from the top. The
+// thread creating the system becomes worker 0 and only workers submit jobs.
+// Waiting on a counter runs queued jobs instead of blocking, so a job can
+// wait on the jobs it spawned.
+typedef struct JobSystem JobSystem;
+
+typedef void (*JobFunc)(void* data);
+
+typedef struct Job {
+    JobFunc func;
+    void* data;
+} Job;
+
+// Counts unfinished jobs, zero initialize it before passing it to nb_job_run
+typedef struct JobCounter {
+    volatile u32 value;
+} JobCounter;
+
+// Per worker, jobs pushed past it run inline
+#define NB_JOB_QUEUE_CAPACITY 4096
+
+#define NB_JOB_WORKER_NONE 0xFFFFFFFFu
+
+// A worker_count of 0 uses one worker per CPU, 'pin_threads' pins worker i to
+// the i-th CPU the process may run on. The creator's affinity is restored by
+// nb_job_system_destroy.
+JobSystem*  nb_job_system_create(Arena* arena, u32 worker_count, b32 pin_threads);
+// Stops and joins the workers, call from the creating thread once all jobs are done
+void        nb_job_system_destroy(JobSystem* js);
+u32         nb_job_system_worker_count(JobSystem* js);
+// NB_JOB_WORKER_NONE if the calling thread isn't a worker
+u32         nb_job_worker_index(void);
+
+// Adds 'count' to 'counter' (may be null) and queues the jobs
+void        nb_job_run(JobSystem* js, Job* jobs, usize count, JobCounter* counter);
+// Runs queued jobs until 'counter' reaches zero
+void        nb_job_wait(JobSystem* js, JobCounter* counter);
+
+typedef void (*JobRangeFunc)(void* data, usize start, usize end);
+
+// Calls 'func' over [0, count) in ranges of 'batch_size' spread over all
+// workers and returns when they are done. A batch_size of 0 picks one.
+void        nb_job_parallel_for(JobSystem* js, usize count, usize batch_size, JobRangeFunc func, void* data);
+
 
 
 #endif // BASE_H_
\ No newline at end of file
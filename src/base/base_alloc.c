@@ -0,0 +1,214 @@
+#include "base.h"
+#include <string.h>
+
+// Each size class is a growable Pool living in its own growable arena, so a
+// pointer's class is found from the address range it falls in. Anything
+// bigger than the largest class gets its own reservation with a small
+// header recording the size.
+
+typedef struct SizeClass {
+    Arena* arena;
+    Pool* pool;
+    volatile u32 lock;
+    usize alloc_count;
+} SizeClass;
+
+typedef struct LargeAllocHeader {
+    usize total_size;
+} LargeAllocHeader;
+
+#define NB_ALLOC_LARGE_HEADER_SIZE NB_MAX(sizeof(LargeAllocHeader), NB_DEFAULT_ALIGNMENT)
+
+global SizeClass nb_alloc_classes[NB_ALLOC_CLASS_COUNT];
+global volatile u32 nb_alloc_state = 0; // 0 uninitialized, 1 initializing, 2 ready
+global volatile u64 nb_alloc_large_count = 0;
+global volatile u64 nb_alloc_large_used = 0;
+global volatile u64 nb_alloc_large_peak = 0;
+
+internal void nb_alloc_init(void) {
+    if (nb_atomic_load_u32(&nb_alloc_state) == 2) {
+        return;
+    }
+    if (!nb_atomic_cas_u32(&nb_alloc_state, 0, 1)) {
+        while (nb_atomic_load_u32(&nb_alloc_state) != 2) {
+            NB_CPU_PAUSE();
+        }
+        return;
+    }
+
+    for (usize i = 0; i < NB_ALLOC_CLASS_COUNT; i++) {
+        usize object_size = nb_alloc_class_size(i);
+        usize chunk_count = NB_MAX(NB_ALLOC_CHUNK_SIZE / object_size, 1);
+        SizeClass* sc = &nb_alloc_classes[i];
+        sc->arena = nb_arena_create_growable(NB_ALLOC_CLASS_RESERVE_SIZE, NB_ALLOC_CHUNK_SIZE);
+        NB_ASSERT_MSG(sc->arena, "Failed to reserve size class arena");
+        sc->pool = nb_pool_create_growable(sc->arena, object_size, chunk_count);
+        nb_pool_set_free_check(sc->pool, false);
+        sc->lock = 0;
+        sc->alloc_count = 0;
+    }
+
+    nb_atomic_store_u32(&nb_alloc_state, 2);
+}
+
+usize nb_alloc_class_size(usize class_index) {
+    return (usize)NB_ALLOC_MIN_SIZE << class_index;
+}
+
+internal NB_FORCE_INLINE usize nb_alloc_class_index(usize size) {
+    if (size <= NB_ALLOC_MIN_SIZE) {
+        return 0;
+    }
+    // ceil(log2(size)) - log2(NB_ALLOC_MIN_SIZE)
+    u32 log2_size = 64 - nb_count_leading_zeros64((u64)size - 1);
+    return log2_size - 4;
+}
+
+// Returns NB_ALLOC_CLASS_COUNT for large allocations
+internal usize nb_alloc_class_of(void* ptr) {
+    uptr addr = (uptr)ptr;
+    for (usize i = 0; i < NB_ALLOC_CLASS_COUNT; i++) {
+        Arena* arena = nb_alloc_classes[i].arena;
+        uptr start = (uptr)arena->mem;
+        if (addr >= start && addr < start + arena->size) {
+            return i;
+        }
+    }
+    return NB_ALLOC_CLASS_COUNT;
+}
+
+// O(1) stand-in for the pool's chunk walk: the pointer has to lie in the
+// part of the class arena handed out so far and keep the slot alignment.
+// Chunk headers sit between chunks, so the offset isn't a multiple of the
+// object size and can't be checked against it.
+internal b32 nb_alloc_validate_class_ptr(usize class_index, void* ptr) {
+    Arena* arena = nb_alloc_classes[class_index].arena;
+    uptr offset = (uptr)ptr - (uptr)arena->mem;
+    usize align = NB_MIN(nb_alloc_class_size(class_index), (usize)NB_DEFAULT_ALIGNMENT);
+    return offset < arena->marker && ((uptr)ptr & (align - 1)) == 0;
+}
+
+internal void* nb_alloc_large(usize size) {
+    usize total_size = size + NB_ALLOC_LARGE_HEADER_SIZE;
+    u8* mem = platform_memory_reserve(total_size);
+    if (!mem) {
+        return null;
+    }
+    platform_memory_commit(mem, total_size);
+    ((LargeAllocHeader*)mem)->total_size = total_size;
+
+    nb_atomic_add_u64(&nb_alloc_large_count, 1);
+    u64 used = nb_atomic_add_u64(&nb_alloc_large_used, size) + size;
+    u64 peak = nb_atomic_load_u64(&nb_alloc_large_peak);
+    while (used > peak && !nb_atomic_cas_u64(&nb_alloc_large_peak, peak, used)) {
+        peak = nb_atomic_load_u64(&nb_alloc_large_peak);
+    }
+    return mem + NB_ALLOC_LARGE_HEADER_SIZE;
+}
+
+internal LargeAllocHeader* nb_alloc_large_header(void* ptr) {
+    return (LargeAllocHeader*)((u8*)ptr - NB_ALLOC_LARGE_HEADER_SIZE);
+}
+
+void* nb_alloc(usize size) {
+    nb_alloc_init();
+    usize class_index = nb_alloc_class_index(size);
+    if (class_index >= NB_ALLOC_CLASS_COUNT) {
+        return nb_alloc_large(size);
+    }
+
+    SizeClass* sc = &nb_alloc_classes[class_index];
+    nb_spin_lock(&sc->lock);
+    void* ptr = nb_pool_alloc(sc->pool);
+    if (ptr) {
+        sc->alloc_count++;
+    }
+    nb_spin_unlock(&sc->lock);
+    return ptr;
+}
+
+void nb_free(void* ptr) {
+    if (ptr == null) {
+        return;
+    }
+
+    nb_alloc_init();
+    usize class_index = nb_alloc_class_of(ptr);
+    if (class_index == NB_ALLOC_CLASS_COUNT) {
+        LargeAllocHeader* header = nb_alloc_large_header(ptr);
+        usize total_size = header->total_size;
+        nb_atomic_add_u64(&nb_alloc_large_used, (u64)0 - (total_size - NB_ALLOC_LARGE_HEADER_SIZE));
+        platform_memory_decommit(header, total_size);
+        platform_memory_release(header, total_size);
+        return;
+    }
+
+#ifdef NB_BUILD_DEBUG
+    NB_ASSERT_MSG(nb_alloc_validate_class_ptr(class_index, ptr), "nb_free: Invalid pointer");
+#endif
+    SizeClass* sc = &nb_alloc_classes[class_index];
+    nb_spin_lock(&sc->lock);
+    nb_pool_free(sc->pool, ptr);
+    nb_spin_unlock(&sc->lock);
+}
+
+void* nb_realloc(void* ptr, usize size) {
+    if (ptr == null) {
+        return nb_alloc(size);
+    }
+    if (size == 0) {
+        nb_free(ptr);
+        return null;
+    }
+
+    usize old_class = nb_alloc_class_of(ptr);
+    usize old_size;
+    if (old_class == NB_ALLOC_CLASS_COUNT) {
+        old_size = nb_alloc_large_header(ptr)->total_size - NB_ALLOC_LARGE_HEADER_SIZE;
+    } else {
+        old_size = nb_alloc_class_size(old_class);
+    }
+
+    // Still fits the same slot
+    if (old_class < NB_ALLOC_CLASS_COUNT && old_class == nb_alloc_class_index(size)) {
+        return ptr;
+    }
+
+    void* new_ptr = nb_alloc(size);
+    if (new_ptr == null) {
+        return null;
+    }
+    memcpy(new_ptr, ptr, NB_MIN(old_size, size));
+    nb_free(ptr);
+    return new_ptr;
+}
+
+char* nb_strdup(const char* str) {
+    usize length = strlen(str) + 1;
+    char* copy = nb_alloc(length);
+    if (copy) {
+        memcpy(copy, str, length);
+    }
+    return copy;
+}
+
+void nb_alloc_get_stats(usize class_index, AllocatorStats* stats) {
+    NB_ASSERT(class_index <= NB_ALLOC_CLASS_COUNT);
+    nb_alloc_init();
+
+    if (class_index == NB_ALLOC_CLASS_COUNT) {
+        stats->object_size = 0;
+        stats->alloc_count = (usize)nb_atomic_load_u64(&nb_alloc_large_count);
+        stats->used_memory = (usize)nb_atomic_load_u64(&nb_alloc_large_used);
+        stats->peak_memory = (usize)nb_atomic_load_u64(&nb_alloc_large_peak);
+        return;
+    }
+
+    SizeClass* sc = &nb_alloc_classes[class_index];
+    nb_spin_lock(&sc->lock);
+    stats->object_size = nb_alloc_class_size(class_index);
+    stats->alloc_count = sc->alloc_count;
+    stats->used_memory = nb_pool_used_memory(sc->pool);
+    stats->peak_memory = nb_pool_peak_memory(sc->pool);
+    nb_spin_unlock(&sc->lock);
+}
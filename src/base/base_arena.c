@@ -1,4 +1,5 @@
 #include "base.h"
+#include <string.h>
 
 // Aligned Allocator --------------------------------------------
 
@@ -58,53 +59,267 @@ void nb_aligned_free(void* ptr, usize size, usize align) {
 
 // Arena Allocator --------------------------------------------
 
+// An arena is a chain of blocks. The root block is the Arena handle callers
+// hold, non chained arenas are a single block where current == the arena.
 struct Arena {
-    void* mem;
-    usize marker;
-    usize size;
-    usize peak_size;
-    b32   is_platform_allocated;
+    void*  mem;
+    usize  marker;              // Position within this block's buffer
+    usize  size;                // Size of this block's buffer
+    usize  committed;           // Bytes of this block's buffer backed by memory
+    usize  base_pos;            // Position of this block's buffer within the chain
+    Arena* prev;                // Previous block in the chain
+
+    // Only valid on the root block
+    Arena* current;             // Block allocations come from
+    Arena* free_blocks;         // Blocks released by nb_arena_free_to_marker
+    Arena* parent;
+    usize  peak_size;
+    usize  block_size;
+    usize  commit_granularity;
+    usize  decommit_retain;
+    u32    flags;
+    u32    memory_flags;
+    u32    numa_node;
+#ifdef NB_TELEMETRY_ENABLED
+    MemoryTelemetry telemetry;
+#endif
+
+    b32    is_platform_allocated;
 };
 
 Arena* nb_arena_create(Arena* parent, usize size) {
+    ArenaParams params = {0};
+    params.reserve_size = size;
+    params.commit_size = size;
+    return nb_arena_create_with_params(parent, &params);
+}
+
+Arena* nb_arena_create_growable(usize reserve_size, usize commit_granularity) {
+    ArenaParams params = {0};
+    params.reserve_size = reserve_size;
+    params.commit_granularity = commit_granularity;
+    params.flags = ARENA_FLAG_GROWABLE;
+    return nb_arena_create_with_params(null, &params);
+}
+
+Arena* nb_arena_create_on_node(usize reserve_size, usize commit_granularity, u32 node) {
+    ArenaParams params = {0};
+    params.reserve_size = reserve_size;
+    params.commit_granularity = commit_granularity;
+    params.flags = ARENA_FLAG_GROWABLE | ARENA_FLAG_NUMA_BIND;
+    params.numa_node = node;
+    return nb_arena_create_with_params(null, &params);
+}
+
+Arena* nb_arena_create_chained(Arena* parent, usize block_size) {
+    ArenaParams params = {0};
+    params.reserve_size = block_size;
+    params.commit_size = block_size;
+    params.block_size = block_size;
+    params.flags = ARENA_FLAG_CHAINED;
+    return nb_arena_create_with_params(parent, &params);
+}
+
+// Reserves (or carves out of parent) a block header + buffer
+internal Arena* nb_arena_block_create(
+    Arena* parent, 
+    usize size, 
+    usize commit_size, 
+    usize granularity, 
+    u32 flags,
+    u32 memory_flags,
+    u32 numa_node) 
+{
     void* mem; // ptr to arena struct + backing buffer 
     usize total_size = sizeof(Arena) + size;
+
+    usize committed = total_size;
     if (parent) {
         mem = nb_arena_alloc(parent, total_size);
+        if (!mem) {
+            return null;
+        }
     } else {
-        mem = platform_memory_reserve(total_size);
+        // Large page reservations come in whole large pages, use all of it
+        if (memory_flags & (PLATFORM_MEMORY_FLAG_HUGE_PAGES | PLATFORM_MEMORY_FLAG_LARGE_PAGES)) {
+            total_size = nb_align_address(total_size, platform_memory_get_large_page_size());
+            committed = total_size;
+        }
+
+        mem = platform_memory_reserve_ex(total_size, memory_flags);
         if (!mem) {
             return null;
         }
-        platform_memory_commit(mem, total_size);
+        // Bind before committing so prefaulted pages land on the node too
+        if (flags & ARENA_FLAG_NUMA_BIND) {
+            platform_memory_bind_node(mem, total_size, numa_node);
+        }
+        if (flags & ARENA_FLAG_GROWABLE) {
+            committed = nb_align_address(sizeof(Arena) + commit_size, granularity);
+            committed = NB_MIN(committed, total_size);
+        }
+        platform_memory_commit_ex(mem, committed, memory_flags);
+    }
+
+    Arena* block = (Arena*)mem;
+    memset(block, 0, sizeof(Arena));
+    block->mem = (u8*)mem + sizeof(Arena);
+    block->size = total_size - sizeof(Arena);
+    block->committed = committed - sizeof(Arena);
+    block->is_platform_allocated = !parent;
+    return block;
+}
+
+internal void nb_arena_block_destroy(Arena* block) {
+    if (block->is_platform_allocated) {
+        usize total_size = sizeof(Arena) + block->size;
+        platform_memory_decommit(block, total_size);
+        platform_memory_release(block, total_size);
+    }
+}
+
+Arena* nb_arena_create_with_params(Arena* parent, const ArenaParams* params) {
+    usize page_size = platform_memory_get_page_size();
+    usize granularity = params->commit_granularity ? params->commit_granularity : NB_ARENA_DEFAULT_COMMIT_GRANULARITY;
+    granularity = nb_align_address(granularity, page_size);
+    if (!parent && (params->memory_flags & 
+        (PLATFORM_MEMORY_FLAG_HUGE_PAGES | PLATFORM_MEMORY_FLAG_LARGE_PAGES))) {
+        granularity = nb_align_address(granularity, platform_memory_get_large_page_size());
     }
 
-    Arena* arena = (Arena*)mem;
-    arena->mem = (u8*)mem + sizeof(Arena);
-    arena->marker = 0;
-    arena->size = size;
-    arena->peak_size = 0;
-    arena->is_platform_allocated = !parent;
+    // Arenas living inside a parent are always fully backed
+    u32 flags = params->flags;
+    if (parent) {
+        flags &= ~(ARENA_FLAG_GROWABLE | ARENA_FLAG_NUMA_BIND);
+    }
+    if (!(flags & ARENA_FLAG_GROWABLE)) {
+        flags &= ~ARENA_FLAG_DECOMMIT;
+    }
+
+    Arena* arena = nb_arena_block_create(parent, params->reserve_size, 
+        params->commit_size, granularity, flags, params->memory_flags, params->numa_node);
+    if (!arena) {
+        return null;
+    }
+
+    arena->current = arena;
+    arena->parent = parent;
+    arena->block_size = params->block_size ? params->block_size : params->reserve_size;
+    arena->commit_granularity = granularity;
+    arena->decommit_retain = nb_align_address(params->decommit_retain, page_size);
+    arena->flags = flags;
+    arena->memory_flags = params->memory_flags;
+    arena->numa_node = params->numa_node;
 
     return arena;
-    
 }
 
 void nb_arena_destroy(Arena* arena) {
-    if (arena->is_platform_allocated) {
-        usize total_size = sizeof(Arena) + arena->size;
-        platform_memory_decommit(arena, total_size);
-        platform_memory_release(arena, total_size);
+    Arena* block = arena->current;
+    while (block != arena) {
+        Arena* prev = block->prev;
+        nb_arena_block_destroy(block);
+        block = prev;
+    }
+    block = arena->free_blocks;
+    while (block) {
+        Arena* next = block->prev;
+        nb_arena_block_destroy(block);
+        block = next;
+    }
+    nb_arena_block_destroy(arena);
+}
+
+// Commits enough of the block's reserved range to back its buffer up to 'end'
+internal b32 nb_arena_commit_to(Arena* arena, Arena* block, usize end) {
+    if (end <= block->committed) {
+        return true;
+    }
+    if (!(arena->flags & ARENA_FLAG_GROWABLE)) {
+        return false;
+    }
+
+    // Commit offsets are relative to the block header so they stay page aligned
+    usize commit_start = sizeof(Arena) + block->committed;
+    usize commit_end = nb_align_address(sizeof(Arena) + end, arena->commit_granularity);
+    commit_end = NB_MIN(commit_end, sizeof(Arena) + block->size);
+
+    platform_memory_commit_ex((u8*)block + commit_start, commit_end - commit_start, 
+        arena->memory_flags);
+    block->committed = commit_end - sizeof(Arena);
+    return true;
+}
+
+// Gives committed pages past max(marker, decommit_retain) back to the OS
+internal void nb_arena_decommit_tail(Arena* arena, Arena* block) {
+    if (!(arena->flags & ARENA_FLAG_DECOMMIT)) {
+        return;
+    }
+
+    usize keep = NB_MAX(block->marker, arena->decommit_retain);
+    usize keep_end = nb_align_address(sizeof(Arena) + keep, arena->commit_granularity);
+    usize committed_end = sizeof(Arena) + block->committed;
+    if (keep_end >= committed_end) {
+        return;
+    }
+
+    platform_memory_decommit((u8*)block + keep_end, committed_end - keep_end);
+    block->committed = keep_end - sizeof(Arena);
+}
+
+// Links a block that can hold at least 'min_size' bytes after the current one
+internal Arena* nb_arena_push_block(Arena* arena, usize min_size) {
+    Arena* block = null;
+
+    // Reuse a cached block if one is big enough
+    Arena** link = &arena->free_blocks;
+    while (*link) {
+        if ((*link)->size >= min_size) {
+            block = *link;
+            *link = block->prev;
+            break;
+        }
+        link = &(*link)->prev;
     }
+
+    if (!block) {
+        usize size = NB_MAX(arena->block_size, min_size);
+        block = nb_arena_block_create(arena->parent, size, 
+            NB_MIN(size, arena->commit_granularity), arena->commit_granularity, 
+            arena->flags, arena->memory_flags, arena->numa_node);
+        if (!block) {
+            return null;
+        }
+    }
+
+    Arena* current = arena->current;
+    block->marker = 0;
+    block->base_pos = current->base_pos + current->size;
+    block->prev = current;
+    arena->current = block;
+    return block;
 }
 
 void* nb_arena_alloc_aligned(Arena* arena, usize size, usize align) {
-    uptr base = (uptr)arena->mem;
-    uptr current = base + arena->marker;
+    Arena* block = arena->current;
+    uptr base = (uptr)block->mem;
+    uptr current = base + block->marker;
     uptr aligned = nb_align_address(current, align);
     usize padding = aligned - current;
+    usize end = block->marker + padding + size;
 
-    if (arena->marker + padding + size > arena->size) {
+    if (end > block->size && (arena->flags & ARENA_FLAG_CHAINED)) {
+        block = nb_arena_push_block(arena, size + align);
+        if (!block) {
+            return null;
+        }
+        base = (uptr)block->mem;
+        aligned = nb_align_address(base, align);
+        padding = aligned - base;
+        end = padding + size;
+    }
+
+    if (end > block->size) {
         // TODO:(Novel) Replace with logging system
         platform_debug_print(
             "Arena requested more that total size.."
@@ -113,13 +328,18 @@ void* nb_arena_alloc_aligned(Arena* arena, usize size, usize align) {
             "\n\tPadding: %d bytes"
             "\n\tCurrent size: %d"
             "\nOver max by %d bytes",
-        arena->size, size, padding, arena->marker, (arena->marker + padding + size) - arena->size);
+        block->size, size, padding, block->marker, (block->marker + padding + size) - block->size);
         NB_ASSERT(false);
         return null;
     }
 
-    arena->marker += padding + size;
-    arena->peak_size = NB_MAX(arena->peak_size, arena->marker);
+    if (end > block->committed && !nb_arena_commit_to(arena, block, end)) {
+        return null;
+    }
+
+    block->marker = end;
+    arena->peak_size = NB_MAX(arena->peak_size, block->base_pos + block->marker);
+    NB_TELEMETRY_RECORD(&arena->telemetry, size, padding);
 
     return (void*)aligned;
 }
@@ -129,25 +349,108 @@ void* nb_arena_alloc(Arena* arena, usize size) {
 }
 
 void nb_arena_clear(Arena* arena) {
-    arena->marker = 0;
+    nb_arena_free_to_marker(arena, 0);
 }
 
 usize nb_arena_get_marker(Arena* arena) {
-    return arena->marker;
+    return arena->current->base_pos + arena->current->marker;
 }
 
 void nb_arena_free_to_marker(Arena* arena, usize marker) {
-    NB_ASSERT(marker <= arena->size);
-    arena->marker = marker;
+    // Whole blocks past the marker go back to the free block cache
+    while (arena->current != arena && marker < arena->current->base_pos) {
+        Arena* block = arena->current;
+        arena->current = block->prev;
+
+        block->marker = 0;
+        nb_arena_decommit_tail(arena, block);
+        block->prev = arena->free_blocks;
+        arena->free_blocks = block;
+    }
+
+    Arena* block = arena->current;
+    NB_ASSERT(marker - block->base_pos <= block->size);
+    block->marker = marker - block->base_pos;
+    nb_arena_decommit_tail(arena, block);
 }
 
 usize nb_arena_used_memory(Arena* arena) {
-    return arena->marker;
+    return nb_arena_get_marker(arena);
 }
 usize nb_arena_peak_memory(Arena* arena) {
     return arena->peak_size;
 }
+#ifdef NB_TELEMETRY_ENABLED
+MemoryTelemetry* nb_arena_telemetry(Arena* arena) {
+    return &arena->telemetry;
+}
+#endif
 
+usize nb_arena_committed_memory(Arena* arena) {
+    usize committed = 0;
+    for (Arena* block = arena->current; block; block = block->prev) {
+        committed += block->committed;
+    }
+    return committed;
+}
+
+// Temporary Arena ------------------------------------------------------
 
+TempArena nb_temp_arena_begin(Arena* arena) {
+    TempArena temp;
+    temp.arena = arena;
+    temp.marker = nb_arena_get_marker(arena);
+    return temp;
+}
+
+void nb_temp_arena_end(TempArena temp) {
+    nb_arena_free_to_marker(temp.arena, temp.marker);
+}
 
+// Scratch Arenas -------------------------------------------------------
 
+global NB_THREAD_LOCAL Arena* nb_scratch_arenas[NB_SCRATCH_ARENA_COUNT];
+
+internal Arena* nb_scratch_get(usize index) {
+    if (!nb_scratch_arenas[index]) {
+        ArenaParams params = {0};
+        params.reserve_size = NB_SCRATCH_ARENA_RESERVE_SIZE;
+        params.flags = ARENA_FLAG_GROWABLE;
+        nb_scratch_arenas[index] = nb_arena_create_with_params(null, &params);
+        NB_ASSERT_MSG(nb_scratch_arenas[index], "Failed to reserve scratch arena");
+    }
+    return nb_scratch_arenas[index];
+}
+
+TempArena nb_scratch_begin(Arena** conflicts, usize conflict_count) {
+    for (usize i = 0; i < NB_SCRATCH_ARENA_COUNT; i++) {
+        Arena* candidate = nb_scratch_arenas[i];
+        b32 has_conflict = false;
+        for (usize j = 0; j < conflict_count; j++) {
+            if (candidate != null && conflicts[j] == candidate) {
+                has_conflict = true;
+                break;
+            }
+        }
+        if (!has_conflict) {
+            return nb_temp_arena_begin(nb_scratch_get(i));
+        }
+    }
+
+    NB_ASSERT_MSG(false, "No scratch arena free of conflicts, raise NB_SCRATCH_ARENA_COUNT");
+    TempArena none = {0};
+    return none;
+}
+
+void nb_scratch_end(TempArena temp) {
+    nb_temp_arena_end(temp);
+}
+
+void nb_scratch_release_thread(void) {
+    for (usize i = 0; i < NB_SCRATCH_ARENA_COUNT; i++) {
+        if (nb_scratch_arenas[i]) {
+            nb_arena_destroy(nb_scratch_arenas[i]);
+            nb_scratch_arenas[i] = null;
+        }
+    }
+}
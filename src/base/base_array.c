@@ -0,0 +1,63 @@
+#include "base.h"
+
+// Virtual Array -------------------------------------------------------
+
+b32 nb_varray_create(VirtualArray* array, usize item_size, usize max_count) {
+    NB_ASSERT(item_size > 0 && max_count > 0);
+    // item_size * max_count would wrap and reserve too little
+    if (max_count > SIZE_MAX / item_size) {
+        return false;
+    }
+    array->data = platform_memory_reserve(item_size * max_count);
+    if (array->data == null) {
+        return false;
+    }
+    array->count = 0;
+    array->capacity = 0;
+    array->max_count = max_count;
+    array->item_size = item_size;
+    return true;
+}
+
+void nb_varray_destroy(VirtualArray* array) {
+    usize reserved = array->item_size * array->max_count;
+    platform_memory_decommit(array->data, reserved);
+    platform_memory_release(array->data, reserved);
+    array->data = null;
+    array->count = 0;
+    array->capacity = 0;
+}
+
+void* nb_varray_push(VirtualArray* array, usize count) {
+    if (count > array->max_count - array->count) {
+        // TODO:(Novel) Log error here
+        return null;
+    }
+
+    usize new_count = array->count + count;
+    if (new_count > array->capacity) {
+        usize committed = array->capacity * array->item_size;
+        usize reserved = array->max_count * array->item_size;
+        usize needed = nb_align_address(new_count * array->item_size, NB_VARRAY_COMMIT_SIZE);
+        needed = NB_MIN(needed, reserved);
+
+        // Commit from the page holding the end of the committed range
+        usize page_size = platform_memory_get_page_size();
+        usize commit_start = committed & ~(page_size - 1);
+        platform_memory_commit(array->data + commit_start, needed - commit_start);
+        array->capacity = needed / array->item_size;
+    }
+
+    void* items = array->data + array->count * array->item_size;
+    array->count = new_count;
+    return items;
+}
+
+void nb_varray_pop(VirtualArray* array, usize count) {
+    NB_ASSERT(count <= array->count);
+    array->count -= count;
+}
+
+void nb_varray_clear(VirtualArray* array) {
+    array->count = 0;
+}
@@ -0,0 +1,183 @@
+#include "base.h"
+#include <string.h>
+
+// Reads and writes that are at least a whole buffer skip the copy and go
+// straight to the file, but only when the caller's memory and the file
+// offset are page aligned so DIRECT files keep working.
+
+struct FileReader {
+    PlatformFile* file;
+    u8* buffer;
+    usize capacity;
+    usize pos;          // Next unread byte in buffer
+    usize end;          // Bytes of buffer holding file data
+    u64 position;
+    b32 at_end;
+};
+
+struct FileWriter {
+    PlatformFile* file;
+    u8* buffer;
+    usize capacity;
+    usize used;
+    u64 position;
+    b32 failed;
+};
+
+internal usize nb_file_buffer_size(usize buffer_size) {
+    usize page_size = platform_memory_get_page_size();
+    if (buffer_size == 0) {
+        buffer_size = NB_FILE_BUFFER_DEFAULT_SIZE;
+    }
+    return (buffer_size + page_size - 1) & ~(page_size - 1);
+}
+
+internal b32 nb_file_is_page_aligned(const void* memory, u64 offset) {
+    usize mask = platform_memory_get_page_size() - 1;
+    return ((uptr)memory & mask) == 0 && (offset & mask) == 0;
+}
+
+// Reader --------------------------------------------------------------
+
+FileReader* nb_file_reader_create(Arena* arena, PlatformFile* file, usize buffer_size) {
+    FileReader* reader = nb_arena_alloc(arena, sizeof(FileReader));
+    if (reader == null) {
+        return null;
+    }
+    memset(reader, 0, sizeof(FileReader));
+    reader->file = file;
+    reader->capacity = nb_file_buffer_size(buffer_size);
+    reader->buffer = nb_arena_alloc_aligned(arena, reader->capacity, platform_memory_get_page_size());
+    if (reader->buffer == null) {
+        return null;
+    }
+    return reader;
+}
+
+internal b32 nb_file_reader_fill(FileReader* reader) {
+    if (reader->at_end) {
+        return false;
+    }
+    reader->pos = 0;
+    reader->end = platform_file_read(reader->file, reader->buffer, reader->capacity);
+    if (reader->end < reader->capacity) {
+        reader->at_end = true;
+    }
+    return reader->end > 0;
+}
+
+usize nb_file_reader_read(FileReader* reader, void* buffer, usize size) {
+    u8* dst = buffer;
+    usize total = 0;
+    while (total < size) {
+        usize available = reader->end - reader->pos;
+        if (available == 0) {
+            usize remaining = size - total;
+            if (remaining >= reader->capacity && !reader->at_end &&
+                nb_file_is_page_aligned(dst + total, reader->position)) {
+                usize direct = remaining - remaining % reader->capacity;
+                usize result = platform_file_read(reader->file, dst + total, direct);
+                total += result;
+                reader->position += result;
+                if (result < direct) {
+                    reader->at_end = true;
+                    break;
+                }
+                continue;
+            }
+            if (!nb_file_reader_fill(reader)) {
+                break;
+            }
+            continue;
+        }
+
+        usize count = NB_MIN(available, size - total);
+        memcpy(dst + total, reader->buffer + reader->pos, count);
+        reader->pos += count;
+        reader->position += count;
+        total += count;
+    }
+    return total;
+}
+
+const void* nb_file_reader_peek(FileReader* reader, usize size, usize* out_size) {
+    if (reader->pos == reader->end) {
+        nb_file_reader_fill(reader);
+    }
+    *out_size = NB_MIN(size, reader->end - reader->pos);
+    return reader->buffer + reader->pos;
+}
+
+void nb_file_reader_skip(FileReader* reader, usize size) {
+    while (size > 0) {
+        if (reader->pos == reader->end && !nb_file_reader_fill(reader)) {
+            return;
+        }
+        usize count = NB_MIN(size, reader->end - reader->pos);
+        reader->pos += count;
+        reader->position += count;
+        size -= count;
+    }
+}
+
+u64 nb_file_reader_position(FileReader* reader) {
+    return reader->position;
+}
+
+// Writer --------------------------------------------------------------
+
+FileWriter* nb_file_writer_create(Arena* arena, PlatformFile* file, usize buffer_size) {
+    FileWriter* writer = nb_arena_alloc(arena, sizeof(FileWriter));
+    if (writer == null) {
+        return null;
+    }
+    memset(writer, 0, sizeof(FileWriter));
+    writer->file = file;
+    writer->capacity = nb_file_buffer_size(buffer_size);
+    writer->buffer = nb_arena_alloc_aligned(arena, writer->capacity, platform_memory_get_page_size());
+    if (writer->buffer == null) {
+        return null;
+    }
+    return writer;
+}
+
+b32 nb_file_writer_flush(FileWriter* writer) {
+    if (writer->used > 0 && !writer->failed) {
+        usize result = platform_file_write(writer->file, writer->buffer, writer->used);
+        writer->failed = result != writer->used;
+    }
+    writer->used = 0;
+    return !writer->failed;
+}
+
+b32 nb_file_writer_write(FileWriter* writer, const void* buffer, usize size) {
+    const u8* src = buffer;
+    writer->position += size;
+    while (size > 0) {
+        // With the buffer empty the file offset is where 'src' goes
+        u64 offset = writer->position - size;
+        if (writer->used == 0 && size >= writer->capacity && nb_file_is_page_aligned(src, offset)) {
+            usize direct = size - size % writer->capacity;
+            if (!writer->failed && platform_file_write(writer->file, (void*)src, direct) != direct) {
+                writer->failed = true;
+            }
+            src += direct;
+            size -= direct;
+            continue;
+        }
+
+        usize count = NB_MIN(size, writer->capacity - writer->used);
+        memcpy(writer->buffer + writer->used, src, count);
+        writer->used += count;
+        src += count;
+        size -= count;
+        if (writer->used == writer->capacity) {
+            nb_file_writer_flush(writer);
+        }
+    }
+    return !writer->failed;
+}
+
+u64 nb_file_writer_position(FileWriter* writer) {
+    return writer->position;
+}
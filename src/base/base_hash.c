@@ -0,0 +1,109 @@
+// Port of wyhash final4 by Wang Yi (public domain):
+// https://github.com/wangyi-fudan/wyhash
+
+#include "base.h"
+#include <string.h>
+
+global const u64 nb_hash_secret[4] = {
+    0x2d358dccaa6c78a5ULL, 0x8bb84b93962eacc9ULL, 
+    0x4b33a62ed433d4a3ULL, 0x4d5a2da51de1aa47ULL,
+};
+
+// 64x64 -> 128 bit multiply, low half in a and high half in b
+internal NB_FORCE_INLINE void nb_hash_mum(u64* a, u64* b) {
+#if defined(__SIZEOF_INT128__)
+    __uint128_t r = (__uint128_t)*a * *b;
+    *a = (u64)r;
+    *b = (u64)(r >> 64);
+#elif defined(NB_COMPILER_MSVC) && defined(_M_X64)
+    *a = _umul128(*a, *b, b);
+#else
+    u64 ha = *a >> 32, hb = *b >> 32, la = (u32)*a, lb = (u32)*b;
+    u64 rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb;
+    u64 t = rl + (rm0 << 32);
+    u64 c = t < rl;
+    u64 lo = t + (rm1 << 32);
+    c += lo < t;
+    u64 hi = rh + (rm0 >> 32) + (rm1 >> 32) + c;
+    *a = lo;
+    *b = hi;
+#endif
+}
+
+internal NB_FORCE_INLINE u64 nb_hash_mix(u64 a, u64 b) {
+    nb_hash_mum(&a, &b);
+    return a ^ b;
+}
+
+// Reads assume a little endian target
+internal NB_FORCE_INLINE u64 nb_hash_read8(const u8* p) {
+    u64 v;
+    memcpy(&v, p, 8);
+    return v;
+}
+
+internal NB_FORCE_INLINE u64 nb_hash_read4(const u8* p) {
+    u32 v;
+    memcpy(&v, p, 4);
+    return v;
+}
+
+internal NB_FORCE_INLINE u64 nb_hash_read3(const u8* p, usize k) {
+    return ((u64)p[0] << 16) | ((u64)p[k >> 1] << 8) | p[k - 1];
+}
+
+u64 nb_hash_bytes(const void* data, usize length, u64 seed) {
+    const u8* p = (const u8*)data;
+    const u64* secret = nb_hash_secret;
+    u64 a, b;
+
+    seed ^= nb_hash_mix(seed ^ secret[0], secret[1]);
+    if (length <= 16) {
+        if (length >= 4) {
+            a = (nb_hash_read4(p) << 32) | nb_hash_read4(p + ((length >> 3) << 2));
+            b = (nb_hash_read4(p + length - 4) << 32) | nb_hash_read4(p + length - 4 - ((length >> 3) << 2));
+        } else if (length > 0) {
+            a = nb_hash_read3(p, length);
+            b = 0;
+        } else {
+            a = b = 0;
+        }
+    } else {
+        usize i = length;
+        if (i > 48) {
+            // Three independent lanes over 48 bytes per step keep the
+            // multipliers busy on long keys. There is no SIMD variant, it
+            // would have to produce these exact values on every ISA since
+            // hashes get stored.
+            u64 see1 = seed, see2 = seed;
+            do {
+                seed = nb_hash_mix(nb_hash_read8(p) ^ secret[1], nb_hash_read8(p + 8) ^ seed);
+                see1 = nb_hash_mix(nb_hash_read8(p + 16) ^ secret[2], nb_hash_read8(p + 24) ^ see1);
+                see2 = nb_hash_mix(nb_hash_read8(p + 32) ^ secret[3], nb_hash_read8(p + 40) ^ see2);
+                p += 48;
+                i -= 48;
+            } while (i > 48);
+            seed ^= see1 ^ see2;
+        }
+        while (i > 16) {
+            seed = nb_hash_mix(nb_hash_read8(p) ^ secret[1], nb_hash_read8(p + 8) ^ seed);
+            i -= 16;
+            p += 16;
+        }
+        a = nb_hash_read8(p + i - 16);
+        b = nb_hash_read8(p + i - 8);
+    }
+
+    a ^= secret[1];
+    b ^= seed;
+    nb_hash_mum(&a, &b);
+    return nb_hash_mix(a ^ secret[0] ^ length, b ^ secret[1]);
+}
+
+u64 nb_hash_string(const char* str) {
+    return nb_hash_bytes(str, strlen(str), 0);
+}
+
+u64 nb_hash_u64(u64 value) {
+    return nb_hash_mix(value ^ nb_hash_secret[0], nb_hash_secret[1]);
+}
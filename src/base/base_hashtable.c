@@ -1,146 +1,589 @@
-// Implementation from https://benhoyt.com/writings/hash-table-in-c/
+// Originally from https://benhoyt.com/writings/hash-table-in-c/, the probing
+// now follows Abseil's Swiss tables (https://abseil.io/about/design/swisstables)
 
 #include "base.h"
 #include <string.h>
 
-#define NB_HASHTABLE_FNV_OFFSET 14695981039346656037UL
-#define NB_HASHTABLE_FNV_PRIME 1099511628211UL
+#if defined(NB_SIMD_SSE2)
+#include <emmintrin.h>
+#elif defined(NB_SIMD_NEON)
+#include <arm_neon.h>
+#endif
 
-// Return 64-bit FNV-1a hash for key (NUL-terminated). See description:
-// https://en.wikipedia.org/wiki/Fowler–Noll–Vo_hash_function
-internal u64 nb_hashtable_hash_key(const char* key) {
-    u64 hash = NB_HASHTABLE_FNV_OFFSET;
-    for (const char* p = key; *p; p++) {
-        hash ^= (u64)(unsigned char)(*p);
-        hash *= NB_HASHTABLE_FNV_PRIME;
+internal NB_FORCE_INLINE u64 nb_hashtable_hash_key(const char* key, usize length) {
+    return nb_hash_bytes(key, length, 0);
+}
+
+// Control Bytes --------------------------------------------------------
+
+// Every slot has a control byte: EMPTY, DELETED or the low 7 bits of the
+// key's hash (h2) when full. Lookups compare a whole group of control bytes
+// at once and only touch the entries whose h2 matches. The first group is
+// mirrored past the end so a group can be loaded from any slot.
+
+#define NB_HASHTABLE_GROUP_SIZE     16
+#define NB_HASHTABLE_CTRL_EMPTY     ((u8)0x80)
+#define NB_HASHTABLE_CTRL_DELETED   ((u8)0xFE)
+
+#define NB_HASHTABLE_H1(hash)       ((hash) >> 7)
+#define NB_HASHTABLE_H2(hash)       ((u8)((hash) & 0x7F))
+
+// A set bit per matching slot, NEON sets the top bit of a nibble per slot
+typedef u64 HashtableMask;
+
+#if defined(NB_SIMD_SSE2)
+
+#define NB_HASHTABLE_MASK_SHIFT 0
+
+internal NB_FORCE_INLINE HashtableMask nb_hashtable_group_match(const u8* ctrl, u8 h2) {
+    __m128i group = _mm_loadu_si128((const __m128i*)ctrl);
+    return (u32)_mm_movemask_epi8(_mm_cmpeq_epi8(group, _mm_set1_epi8((char)h2)));
+}
+
+internal NB_FORCE_INLINE HashtableMask nb_hashtable_group_match_empty(const u8* ctrl) {
+    return nb_hashtable_group_match(ctrl, NB_HASHTABLE_CTRL_EMPTY);
+}
+
+internal NB_FORCE_INLINE HashtableMask nb_hashtable_group_match_free(const u8* ctrl) {
+    // EMPTY and DELETED are the only control bytes with the top bit set
+    __m128i group = _mm_loadu_si128((const __m128i*)ctrl);
+    return (u32)_mm_movemask_epi8(group);
+}
+
+#elif defined(NB_SIMD_NEON)
+
+#define NB_HASHTABLE_MASK_SHIFT 2
+
+internal NB_FORCE_INLINE HashtableMask nb_hashtable_neon_mask(uint8x16_t matches) {
+    uint8x8_t narrowed = vshrn_n_u16(vreinterpretq_u16_u8(matches), 4);
+    return vget_lane_u64(vreinterpret_u64_u8(narrowed), 0) & 0x8888888888888888ULL;
+}
+
+internal NB_FORCE_INLINE HashtableMask nb_hashtable_group_match(const u8* ctrl, u8 h2) {
+    return nb_hashtable_neon_mask(vceqq_u8(vld1q_u8(ctrl), vdupq_n_u8(h2)));
+}
+
+internal NB_FORCE_INLINE HashtableMask nb_hashtable_group_match_empty(const u8* ctrl) {
+    return nb_hashtable_group_match(ctrl, NB_HASHTABLE_CTRL_EMPTY);
+}
+
+internal NB_FORCE_INLINE HashtableMask nb_hashtable_group_match_free(const u8* ctrl) {
+    int8x16_t group = vreinterpretq_s8_u8(vld1q_u8(ctrl));
+    return nb_hashtable_neon_mask(vcltq_s8(group, vdupq_n_s8(0)));
+}
+
+#else
+
+#define NB_HASHTABLE_MASK_SHIFT 0
+
+internal NB_FORCE_INLINE HashtableMask nb_hashtable_group_match(const u8* ctrl, u8 h2) {
+    HashtableMask mask = 0;
+    for (u32 i = 0; i < NB_HASHTABLE_GROUP_SIZE; i++) {
+        mask |= (HashtableMask)(ctrl[i] == h2) << i;
+    }
+    return mask;
+}
+
+internal NB_FORCE_INLINE HashtableMask nb_hashtable_group_match_empty(const u8* ctrl) {
+    return nb_hashtable_group_match(ctrl, NB_HASHTABLE_CTRL_EMPTY);
+}
+
+internal NB_FORCE_INLINE HashtableMask nb_hashtable_group_match_free(const u8* ctrl) {
+    HashtableMask mask = 0;
+    for (u32 i = 0; i < NB_HASHTABLE_GROUP_SIZE; i++) {
+        mask |= (HashtableMask)(ctrl[i] >> 7) << i;
+    }
+    return mask;
+}
+
+#endif
+
+// Pops the lowest matching slot offset out of mask
+internal NB_FORCE_INLINE usize nb_hashtable_mask_next(HashtableMask* mask) {
+    usize offset = nb_count_trailing_zeros64(*mask) >> NB_HASHTABLE_MASK_SHIFT;
+    *mask &= *mask - 1;
+    return offset;
+}
+
+internal NB_FORCE_INLINE void nb_hashtable_set_ctrl(u8* ctrl, usize capacity, usize index, u8 value) {
+    ctrl[index] = value;
+    if (index < NB_HASHTABLE_GROUP_SIZE) {
+        ctrl[capacity + index] = value;
+    }
+}
+
+// Returns the first EMPTY or DELETED slot on the probe sequence of hash
+internal usize nb_hashtable_find_free_slot(const u8* ctrl, usize capacity, u64 hash) {
+    usize mask = capacity - 1;
+    usize pos = (usize)NB_HASHTABLE_H1(hash) & mask;
+    usize stride = 0;
+    for (;;) {
+        HashtableMask free_slots = nb_hashtable_group_match_free(ctrl + pos);
+        if (free_slots) {
+            return (pos + nb_hashtable_mask_next(&free_slots)) & mask;
+        }
+        stride += NB_HASHTABLE_GROUP_SIZE;
+        pos = (pos + stride) & mask;
+    }
+}
+
+// Clears a full slot. It can go back to EMPTY only if no probe sequence ever
+// found a full group around it (there's an empty slot within a group width
+// on both sides), otherwise lookups passing through need a DELETED tombstone.
+// Returns true when a tombstone was left.
+internal b32 nb_hashtable_erase_ctrl(u8* ctrl, usize capacity, usize index) {
+    usize mask = capacity - 1;
+    usize index_before = (index - NB_HASHTABLE_GROUP_SIZE) & mask;
+    HashtableMask empty_before = nb_hashtable_group_match_empty(ctrl + index_before);
+    HashtableMask empty_after = nb_hashtable_group_match_empty(ctrl + index);
+
+    b32 was_never_full = false;
+    if (empty_before && empty_after) {
+        usize mask_bits = NB_HASHTABLE_GROUP_SIZE << NB_HASHTABLE_MASK_SHIFT;
+        usize trailing = nb_count_trailing_zeros64(empty_after) >> NB_HASHTABLE_MASK_SHIFT;
+        usize leading = (nb_count_leading_zeros64(empty_before) - (64 - mask_bits)) >> NB_HASHTABLE_MASK_SHIFT;
+        was_never_full = trailing + leading < NB_HASHTABLE_GROUP_SIZE;
+    }
+
+    nb_hashtable_set_ctrl(ctrl, capacity, index, 
+        was_never_full ? NB_HASHTABLE_CTRL_EMPTY : NB_HASHTABLE_CTRL_DELETED);
+    return !was_never_full;
+}
+
+// Number of groups a lookup for 'hash' loads before reaching slot 'index'
+internal usize nb_hashtable_probe_length(usize capacity, u64 hash, usize index) {
+    usize mask = capacity - 1;
+    usize pos = (usize)NB_HASHTABLE_H1(hash) & mask;
+    usize stride = 0;
+    usize groups = 1;
+    while (((index - pos) & mask) >= NB_HASHTABLE_GROUP_SIZE) {
+        stride += NB_HASHTABLE_GROUP_SIZE;
+        pos = (pos + stride) & mask;
+        groups++;
+    }
+    return groups;
+}
+
+// Tables without an arena live on the general allocator
+internal void* nb_hashtable_alloc(Arena* arena, usize size, usize align) {
+    MemoryTag previous_tag = NB_MEMORY_TAG_BEGIN(MEMORY_TAG_HASHTABLE);
+    void* mem = arena ? nb_arena_alloc_aligned(arena, size, align) : nb_alloc(size);
+    NB_MEMORY_TAG_END(previous_tag);
+    return mem;
+}
+
+internal void nb_hashtable_free(Arena* arena, void* ptr) {
+    if (arena == null) {
+        nb_free(ptr);
     }
-    return hash;
 }
 
+internal u8* nb_hashtable_alloc_ctrl(Arena* arena, usize capacity) {
+    usize ctrl_size = capacity + NB_HASHTABLE_GROUP_SIZE;
+    u8* ctrl = nb_hashtable_alloc(arena, ctrl_size, NB_HASHTABLE_GROUP_SIZE);
+    if (ctrl != null) {
+        memset(ctrl, NB_HASHTABLE_CTRL_EMPTY, ctrl_size);
+    }
+    return ctrl;
+}
+
+// Hashtable -----------------------------------------------------------
+
+// Keys are copied into the table's arena, the hash is kept so compares can
+// skip most strings and growing never rehashes
 typedef struct HashtableEntry {
     const char* key;
     void* value;
+    u64 hash;
+    usize length;
 } HashtableEntry;
 
+// While an incremental resize is running the entries not yet migrated stay
+// in the old arrays, migrated slots are marked DELETED there so lookups for
+// the remaining keys still probe past them.
 struct Hashtable {
+    u8* ctrl;
     HashtableEntry* entries;
     usize capacity;
-    usize length;
+    usize length;           // Live entries in both tables
+    usize tombstones;       // DELETED slots in the new arrays
+
+    u8* old_ctrl;
+    HashtableEntry* old_entries;
+    usize old_capacity;
+    usize old_length;       // Live entries left to migrate
+    usize migrate_index;
+
+    b32 is_incremental;
+    b32 is_arena_backed;
 };
 
 #define NB_HASHTABLE_INITIAL_CAPACITY 32
 
-// TODO:(Novel) I should make this use the platform allocator if an arena is not provided
+// Slots moved to the new table per insert during an incremental resize.
+// It only needs to be >= 2 to finish before the new table fills up.
+#define NB_HASHTABLE_MIGRATE_STEP 64
 
-Hashtable* nb_hashtable_create(Arena* arena) {
-    Hashtable* ht = nb_arena_alloc(arena, sizeof(Hashtable));
+// Grow once 7/8 of the slots are used
+#define NB_HASHTABLE_MAX_LOAD(capacity) ((capacity) - (capacity) / 8)
+
+// Keys hashed and prefetched ahead of inserting them in nb_hashtable_set_many
+#define NB_HASHTABLE_BATCH_SIZE 32
+
+// Smallest capacity that holds 'count' entries without growing
+internal usize nb_hashtable_capacity_for(usize count) {
+    usize capacity = NB_HASHTABLE_INITIAL_CAPACITY;
+    while (NB_HASHTABLE_MAX_LOAD(capacity) <= count) {
+        capacity *= 2;
+    }
+    return capacity;
+}
+
+internal Hashtable* nb_hashtable_init(Arena* arena, b32 is_incremental, usize capacity) {
+    Hashtable* ht = nb_hashtable_alloc(arena, sizeof(Hashtable), NB_DEFAULT_ALIGNMENT);
     if (ht == null) {
         return null;
     }
-    ht->length = 0;
-    ht->capacity = NB_HASHTABLE_INITIAL_CAPACITY;
+    memset(ht, 0, sizeof(Hashtable));
+    ht->capacity = capacity;
+    ht->is_incremental = is_incremental;
+    ht->is_arena_backed = arena != null;
 
-    ht->entries = nb_arena_alloc(arena, sizeof(HashtableEntry) * ht->capacity);
-    memset(ht->entries, 0, sizeof(HashtableEntry) * ht->capacity);
-    if (ht->entries == null) {
+    ht->entries = nb_hashtable_alloc(arena, sizeof(HashtableEntry) * ht->capacity, NB_DEFAULT_ALIGNMENT);
+    ht->ctrl = ht->entries ? nb_hashtable_alloc_ctrl(arena, ht->capacity) : null;
+    if (ht->ctrl == null) {
         return null;
     }
     return ht;
 }
 
-void* nb_hashtable_get(Hashtable* ht, const char* key) {
-    u64 hash = nb_hashtable_hash_key(key);
-    usize index = (usize)(hash & (u64)(ht->capacity - 1));
+Hashtable* nb_hashtable_create(Arena* arena) {
+    return nb_hashtable_init(arena, false, NB_HASHTABLE_INITIAL_CAPACITY);
+}
 
-    while (ht->entries[index].key != null) {
-        if(strcmp(key, ht->entries[index].key) == 0) {
-            return ht->entries[index].value;
-        }
-        index++;
-        if (index >= ht->capacity) {
-            index = 0;
-        }
+Hashtable* nb_hashtable_create_incremental(Arena* arena) {
+    return nb_hashtable_init(arena, true, NB_HASHTABLE_INITIAL_CAPACITY);
+}
+
+Hashtable* nb_hashtable_create_with_capacity(Arena* arena, usize count) {
+    return nb_hashtable_init(arena, false, nb_hashtable_capacity_for(count));
+}
+
+void nb_hashtable_destroy(Hashtable* ht) {
+    if (ht->is_arena_backed) {
+        return;
+    }
+    HashtableIterator it = nb_hashtable_iterator(ht);
+    while (nb_hashtable_next(&it)) {
+        nb_free((void*)it.key);
     }
-    return null;
+    nb_free(ht->old_ctrl);
+    nb_free(ht->old_entries);
+    nb_free(ht->ctrl);
+    nb_free(ht->entries);
+    nb_free(ht);
 }
 
-internal 
-const char* 
-nb_hashtable_set_entry(
+internal HashtableEntry* nb_hashtable_find_in(
+    u8* ctrl, 
     HashtableEntry* entries, 
     usize capacity, 
-    const char* key,
-    void* value,
-    usize* length_ptr) 
+    const char* key, 
+    usize length, 
+    u64 hash) 
 {
-    u64 hash = nb_hashtable_hash_key(key);
-    usize index = (usize)(hash & (u64)(capacity - 1));
+    usize mask = capacity - 1;
+    usize pos = (usize)NB_HASHTABLE_H1(hash) & mask;
+    u8 h2 = NB_HASHTABLE_H2(hash);
+    usize stride = 0;
 
-    while (entries[index].key != null) {
-        if (strcmp(key, entries[index].key) == 0) {
-            entries[index].value = value;
-            return entries[index].key;
+    for (;;) {
+        const u8* group = ctrl + pos;
+        HashtableMask matches = nb_hashtable_group_match(group, h2);
+        while (matches) {
+            usize index = (pos + nb_hashtable_mask_next(&matches)) & mask;
+            HashtableEntry* entry = &entries[index];
+            if (entry->hash == hash && entry->length == length && 
+                memcmp(entry->key, key, length) == 0) {
+                return entry;
+            }
         }
-        index++;
-        if (index >= capacity) {
-            index = 0;
+        // An empty slot ends the probe sequence, the key would have gone there
+        if (nb_hashtable_group_match_empty(group)) {
+            return null;
         }
+        stride += NB_HASHTABLE_GROUP_SIZE;
+        pos = (pos + stride) & mask;
     }
+}
 
-    if (length_ptr != null) {
-        key = strdup(key);
-        if (key == null) {
-            return null;
-        }
-        (*length_ptr)++; 
+internal HashtableEntry* nb_hashtable_find(Hashtable* ht, const char* key, usize length, u64 hash) {
+    HashtableEntry* entry = nb_hashtable_find_in(ht->ctrl, ht->entries, ht->capacity, key, length, hash);
+    if (entry == null && ht->old_ctrl != null) {
+        entry = nb_hashtable_find_in(ht->old_ctrl, ht->old_entries, ht->old_capacity, key, length, hash);
     }
-    entries[index].key = (char*)key;
-    entries[index].value = value;
-    return key;
+    return entry;
 }
 
-internal 
-b32 nb_hashtable_expand(Hashtable* ht, Arena *arena) {
-    usize new_capacity = ht->capacity * 2;
-    if (new_capacity < ht->capacity) {
-        return false;
+void* nb_hashtable_get(Hashtable* ht, const char* key) {
+    return nb_hashtable_get_n(ht, key, strlen(key));
+}
+
+void* nb_hashtable_get_n(Hashtable* ht, const char* key, usize length) {
+    HashtableEntry* entry = nb_hashtable_find(ht, key, length, nb_hashtable_hash_key(key, length));
+    return entry ? entry->value : null;
+}
+
+internal NB_FORCE_INLINE void nb_hashtable_insert_entry(Hashtable* ht, HashtableEntry* entry) {
+    usize index = nb_hashtable_find_free_slot(ht->ctrl, ht->capacity, entry->hash);
+    if (ht->ctrl[index] == NB_HASHTABLE_CTRL_DELETED) {
+        ht->tombstones--;
     }
-    HashtableEntry* new_entries = nb_arena_alloc(arena, sizeof(HashtableEntry) * new_capacity);
-    if (new_entries == null) {
-        return false;
+    nb_hashtable_set_ctrl(ht->ctrl, ht->capacity, index, NB_HASHTABLE_H2(entry->hash));
+    ht->entries[index] = *entry;
+}
+
+// Moves up to 'count' old slots into the new arrays, frees the old arrays
+// once they're empty if the table isn't arena backed
+internal void nb_hashtable_migrate(Hashtable* ht, usize count) {
+    if (ht->old_ctrl == null) {
+        return;
     }
 
-    for (usize i = 0; i < ht->capacity; i++) {
-        HashtableEntry entry = ht->entries[i];
-        if(entry.key != null) {
-            nb_hashtable_set_entry(new_entries, new_capacity, 
-                entry.key, entry.value, null);
+    usize end = NB_MIN(ht->migrate_index + count, ht->old_capacity);
+    for (usize i = ht->migrate_index; i < end; i++) {
+        if (ht->old_ctrl[i] & 0x80) {
+            continue;
         }
+        nb_hashtable_insert_entry(ht, &ht->old_entries[i]);
+        nb_hashtable_set_ctrl(ht->old_ctrl, ht->old_capacity, i, NB_HASHTABLE_CTRL_DELETED);
+        ht->old_length--;
     }
+    ht->migrate_index = end;
 
-    // TODO:(Novel) free old entries when not using an arena
-    // if(arena == null) {
-    //     nb_aligned_free(arena, old_entries, size)
-    // }
+    if (ht->migrate_index == ht->old_capacity) {
+        NB_ASSERT(ht->old_length == 0);
+        if (!ht->is_arena_backed) {
+            nb_free(ht->old_ctrl);
+            nb_free(ht->old_entries);
+        }
+        ht->old_ctrl = null;
+        ht->old_entries = null;
+        ht->old_capacity = 0;
+        ht->migrate_index = 0;
+    }
+}
+
+// Moves the entries into new arrays of 'new_capacity' slots
+internal 
+b32 nb_hashtable_resize(Hashtable* ht, Arena *arena, usize new_capacity) {
+    // Never run two resizes at once
+    if (ht->old_ctrl != null) {
+        nb_hashtable_migrate(ht, ht->old_capacity);
+    }
+
+    Arena* table_arena = ht->is_arena_backed ? arena : null;
+    HashtableEntry* new_entries = nb_hashtable_alloc(table_arena, 
+        sizeof(HashtableEntry) * new_capacity, NB_DEFAULT_ALIGNMENT);
+    u8* new_ctrl = new_entries ? nb_hashtable_alloc_ctrl(table_arena, new_capacity) : null;
+    if (new_ctrl == null) {
+        nb_hashtable_free(table_arena, new_entries);
+        return false;
+    }
+
+    ht->old_ctrl = ht->ctrl;
+    ht->old_entries = ht->entries;
+    ht->old_capacity = ht->capacity;
+    ht->old_length = ht->length;
+    ht->migrate_index = 0;
 
     ht->entries = new_entries;
+    ht->ctrl = new_ctrl;
     ht->capacity = new_capacity;
+    ht->tombstones = 0;
+
+    if (!ht->is_incremental) {
+        nb_hashtable_migrate(ht, ht->old_capacity);
+    }
     return true;
 }
 
+// Doubles unless most of the load is tombstones left by removals, in which
+// case they are just cleared out
+internal 
+b32 nb_hashtable_expand(Hashtable* ht, Arena *arena) {
+    usize new_capacity = ht->capacity;
+    if (ht->length >= NB_HASHTABLE_MAX_LOAD(ht->capacity) / 2) {
+        new_capacity *= 2;
+        if (new_capacity < ht->capacity) {
+            return false;
+        }
+    }
+    return nb_hashtable_resize(ht, arena, new_capacity);
+}
+
+b32 nb_hashtable_reserve(Hashtable* ht, Arena* arena, usize count) {
+    usize capacity = nb_hashtable_capacity_for(count);
+    if (capacity <= ht->capacity) {
+        return true;
+    }
+    return nb_hashtable_resize(ht, arena, capacity);
+}
+
 const char* nb_hashtable_set(Hashtable* ht, Arena* arena, const char* key, void* value) {
     NB_ASSERT(value != null);
     if (value == null) {
         return null;
     }
 
-    if (ht->length >= ht->capacity / 2) {
+    nb_hashtable_migrate(ht, NB_HASHTABLE_MIGRATE_STEP);
+
+    // Existing keys are updated wherever they are, even in the old arrays
+    usize length = strlen(key);
+    u64 hash = nb_hashtable_hash_key(key, length);
+    HashtableEntry* existing = nb_hashtable_find(ht, key, length, hash);
+    if (existing != null) {
+        existing->value = value;
+        return existing->key;
+    }
+
+    if (ht->length - ht->old_length + ht->tombstones >= NB_HASHTABLE_MAX_LOAD(ht->capacity)) {
         if (!nb_hashtable_expand(ht, arena)) {
             return null;
         }
     }
 
-    return nb_hashtable_set_entry(ht->entries, ht->capacity, key, value, &ht->length);
+    char* key_copy = nb_hashtable_alloc(ht->is_arena_backed ? arena : null, length + 1, 1);
+    if (key_copy == null) {
+        return null;
+    }
+    memcpy(key_copy, key, length + 1);
+
+    HashtableEntry entry;
+    entry.key = key_copy;
+    entry.value = value;
+    entry.hash = hash;
+    entry.length = length;
+    nb_hashtable_insert_entry(ht, &entry);
+    ht->length++;
+    return key_copy;
+}
+
+usize nb_hashtable_set_many(Hashtable* ht, Arena* arena, const char** keys, void** values, usize count) {
+    // Sized for every key being new so the loop below never grows the table,
+    // a running incremental resize is finished first for the same reason
+    if (!nb_hashtable_reserve(ht, arena, ht->length + ht->tombstones + count)) {
+        return 0;
+    }
+    nb_hashtable_migrate(ht, ht->old_capacity);
+
+    Arena* key_arena = ht->is_arena_backed ? arena : null;
+    usize mask = ht->capacity - 1;
+    usize lengths[NB_HASHTABLE_BATCH_SIZE];
+    u64 hashes[NB_HASHTABLE_BATCH_SIZE];
+
+    for (usize batch = 0; batch < count; batch += NB_HASHTABLE_BATCH_SIZE) {
+        usize batch_count = NB_MIN(count - batch, NB_HASHTABLE_BATCH_SIZE);
+
+        // Hash the whole batch first so the control byte loads overlap
+        // instead of each insert stalling on its own cache miss
+        for (usize i = 0; i < batch_count; i++) {
+            lengths[i] = strlen(keys[batch + i]);
+            hashes[i] = nb_hashtable_hash_key(keys[batch + i], lengths[i]);
+            NB_PREFETCH(ht->ctrl + ((usize)NB_HASHTABLE_H1(hashes[i]) & mask));
+        }
+
+        for (usize i = 0; i < batch_count; i++) {
+            const char* key = keys[batch + i];
+            void* value = values[batch + i];
+            NB_ASSERT(value != null);
+
+            HashtableEntry* existing = nb_hashtable_find_in(ht->ctrl, ht->entries, ht->capacity, 
+                key, lengths[i], hashes[i]);
+            if (existing != null) {
+                existing->value = value;
+                continue;
+            }
+
+            char* key_copy = nb_hashtable_alloc(key_arena, lengths[i] + 1, 1);
+            if (key_copy == null) {
+                return batch + i;
+            }
+            memcpy(key_copy, key, lengths[i] + 1);
+
+            HashtableEntry entry;
+            entry.key = key_copy;
+            entry.value = value;
+            entry.hash = hashes[i];
+            entry.length = lengths[i];
+            nb_hashtable_insert_entry(ht, &entry);
+            ht->length++;
+        }
+    }
+    return count;
+}
+
+b32 nb_hashtable_remove(Hashtable* ht, const char* key) {
+    return nb_hashtable_remove_n(ht, key, strlen(key));
+}
+
+b32 nb_hashtable_remove_n(Hashtable* ht, const char* key, usize length) {
+    nb_hashtable_migrate(ht, NB_HASHTABLE_MIGRATE_STEP);
+
+    u64 hash = nb_hashtable_hash_key(key, length);
+    HashtableEntry* entry = nb_hashtable_find_in(ht->ctrl, ht->entries, ht->capacity, key, length, hash);
+    if (entry != null) {
+        if (nb_hashtable_erase_ctrl(ht->ctrl, ht->capacity, (usize)(entry - ht->entries))) {
+            ht->tombstones++;
+        }
+    } else if (ht->old_ctrl != null) {
+        entry = nb_hashtable_find_in(ht->old_ctrl, ht->old_entries, ht->old_capacity, key, length, hash);
+        if (entry == null) {
+            return false;
+        }
+        // Migration skips DELETED slots so this drops it from the old arrays
+        nb_hashtable_set_ctrl(ht->old_ctrl, ht->old_capacity, 
+            (usize)(entry - ht->old_entries), NB_HASHTABLE_CTRL_DELETED);
+        ht->old_length--;
+    } else {
+        return false;
+    }
+
+    if (!ht->is_arena_backed) {
+        nb_free((void*)entry->key);
+    }
+    ht->length--;
+    return true;
+}
+
+internal void nb_hashtable_stats_add(
+    HashtableStats* stats, 
+    u8* ctrl, 
+    HashtableEntry* entries, 
+    usize capacity, 
+    usize* total_probe_length) 
+{
+    for (usize i = 0; i < capacity; i++) {
+        if (ctrl[i] & 0x80) {
+            continue;
+        }
+        usize probe_length = nb_hashtable_probe_length(capacity, entries[i].hash, i);
+        stats->max_probe_length = NB_MAX(stats->max_probe_length, probe_length);
+        *total_probe_length += probe_length;
+    }
+}
+
+void nb_hashtable_stats(Hashtable* ht, HashtableStats* stats) {
+    usize total_probe_length = 0;
+    stats->length = ht->length;
+    stats->capacity = ht->capacity;
+    stats->tombstones = ht->tombstones;
+    stats->max_probe_length = 0;
+    nb_hashtable_stats_add(stats, ht->ctrl, ht->entries, ht->capacity, &total_probe_length);
+    if (ht->old_ctrl != null) {
+        nb_hashtable_stats_add(stats, ht->old_ctrl, ht->old_entries, ht->old_capacity, &total_probe_length);
+    }
+    stats->average_probe_length = ht->length ? (f64)total_probe_length / (f64)ht->length : 0.0;
 }
 
 usize nb_hashtable_length(Hashtable *ht) {
@@ -154,13 +597,22 @@ HashtableIterator nb_hashtable_iterator(Hashtable *ht) {
     return it;
 }
 
+// Walks the new arrays then whatever hasn't been migrated out of the old ones
 b8 nb_hashtable_next(HashtableIterator *it) {
     Hashtable* ht = it->_table;
-    while(it->_index < ht->capacity) {
+    while(it->_index < ht->capacity + ht->old_capacity) {
         usize i = it->_index;
         it->_index++;
-        if (ht->entries[i].key != null) {
-            HashtableEntry entry = ht->entries[i];
+
+        u8* ctrl = ht->ctrl;
+        HashtableEntry* entries = ht->entries;
+        if (i >= ht->capacity) {
+            i -= ht->capacity;
+            ctrl = ht->old_ctrl;
+            entries = ht->old_entries;
+        }
+        if (!(ctrl[i] & 0x80)) {
+            HashtableEntry entry = entries[i];
             it->key = entry.key;
             it->value = entry.value;
             return true;
@@ -168,3 +620,391 @@ b8 nb_hashtable_next(HashtableIterator *it) {
     }
     return false;
 }
+
+// Integer Hashtable ---------------------------------------------------
+
+// Same control byte layout as Hashtable with the key stored inline, the
+// typed u32/u64/pointer tables in base.h are thin wrappers over this.
+
+typedef struct IntHashtableEntry {
+    u64 key;
+    void* value;
+} IntHashtableEntry;
+
+struct IntHashtable {
+    u8* ctrl;
+    IntHashtableEntry* entries;
+    usize capacity;
+    usize length;
+    usize tombstones;
+    b32 is_arena_backed;
+};
+
+IntHashtable* nb_int_hashtable_create(Arena* arena) {
+    IntHashtable* ht = nb_hashtable_alloc(arena, sizeof(IntHashtable), NB_DEFAULT_ALIGNMENT);
+    if (ht == null) {
+        return null;
+    }
+    ht->capacity = NB_HASHTABLE_INITIAL_CAPACITY;
+    ht->length = 0;
+    ht->tombstones = 0;
+    ht->is_arena_backed = arena != null;
+    ht->entries = nb_hashtable_alloc(arena, sizeof(IntHashtableEntry) * ht->capacity, NB_DEFAULT_ALIGNMENT);
+    ht->ctrl = ht->entries ? nb_hashtable_alloc_ctrl(arena, ht->capacity) : null;
+    if (ht->ctrl == null) {
+        return null;
+    }
+    return ht;
+}
+
+void nb_int_hashtable_destroy(IntHashtable* ht) {
+    if (ht->is_arena_backed) {
+        return;
+    }
+    nb_free(ht->ctrl);
+    nb_free(ht->entries);
+    nb_free(ht);
+}
+
+internal NB_FORCE_INLINE IntHashtableEntry* nb_int_hashtable_find(IntHashtable* ht, u64 key, u64 hash) {
+    usize mask = ht->capacity - 1;
+    usize pos = (usize)NB_HASHTABLE_H1(hash) & mask;
+    u8 h2 = NB_HASHTABLE_H2(hash);
+    usize stride = 0;
+
+    for (;;) {
+        const u8* group = ht->ctrl + pos;
+        HashtableMask matches = nb_hashtable_group_match(group, h2);
+        while (matches) {
+            usize index = (pos + nb_hashtable_mask_next(&matches)) & mask;
+            if (ht->entries[index].key == key) {
+                return &ht->entries[index];
+            }
+        }
+        if (nb_hashtable_group_match_empty(group)) {
+            return null;
+        }
+        stride += NB_HASHTABLE_GROUP_SIZE;
+        pos = (pos + stride) & mask;
+    }
+}
+
+void* nb_int_hashtable_get(IntHashtable* ht, u64 key) {
+    IntHashtableEntry* entry = nb_int_hashtable_find(ht, key, nb_hash_u64(key));
+    return entry ? entry->value : null;
+}
+
+// Rehashes into new arrays, doubling unless most of the load is tombstones
+internal b32 nb_int_hashtable_resize(IntHashtable* ht, Arena* arena) {
+    usize new_capacity = ht->capacity;
+    if (ht->length >= NB_HASHTABLE_MAX_LOAD(ht->capacity) / 2) {
+        new_capacity *= 2;
+        if (new_capacity < ht->capacity) {
+            return false;
+        }
+    }
+
+    Arena* table_arena = ht->is_arena_backed ? arena : null;
+    IntHashtableEntry* new_entries = nb_hashtable_alloc(table_arena, 
+        sizeof(IntHashtableEntry) * new_capacity, NB_DEFAULT_ALIGNMENT);
+    u8* new_ctrl = new_entries ? nb_hashtable_alloc_ctrl(table_arena, new_capacity) : null;
+    if (new_ctrl == null) {
+        nb_hashtable_free(table_arena, new_entries);
+        return false;
+    }
+
+    for (usize i = 0; i < ht->capacity; i++) {
+        if (ht->ctrl[i] & 0x80) {
+            continue;
+        }
+        u64 hash = nb_hash_u64(ht->entries[i].key);
+        usize index = nb_hashtable_find_free_slot(new_ctrl, new_capacity, hash);
+        nb_hashtable_set_ctrl(new_ctrl, new_capacity, index, ht->ctrl[i]);
+        new_entries[index] = ht->entries[i];
+    }
+
+    nb_hashtable_free(table_arena, ht->ctrl);
+    nb_hashtable_free(table_arena, ht->entries);
+    ht->ctrl = new_ctrl;
+    ht->entries = new_entries;
+    ht->capacity = new_capacity;
+    ht->tombstones = 0;
+    return true;
+}
+
+b32 nb_int_hashtable_set(IntHashtable* ht, Arena* arena, u64 key, void* value) {
+    NB_ASSERT(value != null);
+    if (value == null) {
+        return false;
+    }
+
+    u64 hash = nb_hash_u64(key);
+    IntHashtableEntry* existing = nb_int_hashtable_find(ht, key, hash);
+    if (existing != null) {
+        existing->value = value;
+        return true;
+    }
+
+    if (ht->length + ht->tombstones >= NB_HASHTABLE_MAX_LOAD(ht->capacity)) {
+        if (!nb_int_hashtable_resize(ht, arena)) {
+            return false;
+        }
+    }
+
+    usize index = nb_hashtable_find_free_slot(ht->ctrl, ht->capacity, hash);
+    if (ht->ctrl[index] == NB_HASHTABLE_CTRL_DELETED) {
+        ht->tombstones--;
+    }
+    nb_hashtable_set_ctrl(ht->ctrl, ht->capacity, index, NB_HASHTABLE_H2(hash));
+    ht->entries[index].key = key;
+    ht->entries[index].value = value;
+    ht->length++;
+    return true;
+}
+
+b32 nb_int_hashtable_remove(IntHashtable* ht, u64 key) {
+    IntHashtableEntry* entry = nb_int_hashtable_find(ht, key, nb_hash_u64(key));
+    if (entry == null) {
+        return false;
+    }
+    usize index = (usize)(entry - ht->entries);
+    if (nb_hashtable_erase_ctrl(ht->ctrl, ht->capacity, index)) {
+        ht->tombstones++;
+    }
+    ht->length--;
+    return true;
+}
+
+usize nb_int_hashtable_length(IntHashtable* ht) {
+    return ht->length;
+}
+
+void nb_int_hashtable_stats(IntHashtable* ht, HashtableStats* stats) {
+    usize total_probe_length = 0;
+    stats->length = ht->length;
+    stats->capacity = ht->capacity;
+    stats->tombstones = ht->tombstones;
+    stats->max_probe_length = 0;
+    for (usize i = 0; i < ht->capacity; i++) {
+        if (ht->ctrl[i] & 0x80) {
+            continue;
+        }
+        u64 hash = nb_hash_u64(ht->entries[i].key);
+        usize probe_length = nb_hashtable_probe_length(ht->capacity, hash, i);
+        stats->max_probe_length = NB_MAX(stats->max_probe_length, probe_length);
+        total_probe_length += probe_length;
+    }
+    stats->average_probe_length = ht->length ? (f64)total_probe_length / (f64)ht->length : 0.0;
+}
+
+// Concurrent Hashtable ------------------------------------------------
+
+// Linear probing over slots of {hash, entry}. A slot is published by storing
+// its entry pointer last with release order, so a reader that sees the
+// pointer also sees the hash and the entry's key. Slots are never cleared
+// and a table is never more than 3/4 full, so every probe ends at a null
+// slot in a bounded number of steps. Resizing builds a whole new table and
+// swaps the pointer, the old one goes on the retired list.
+
+#define NB_CONCURRENT_HASHTABLE_INITIAL_CAPACITY 64
+#define NB_CONCURRENT_HASHTABLE_MAX_LOAD(c) ((c) / 4 * 3)
+
+typedef struct ConcurrentHashtableEntry {
+    void* volatile value;
+    usize length;
+    char key[];
+} ConcurrentHashtableEntry;
+
+typedef struct ConcurrentHashtableSlot {
+    u64 hash;
+    ConcurrentHashtableEntry* volatile entry;
+} ConcurrentHashtableSlot;
+
+typedef struct ConcurrentHashtableTable {
+    usize capacity;
+    struct ConcurrentHashtableTable* next_retired;
+    ConcurrentHashtableSlot slots[];
+} ConcurrentHashtableTable;
+
+struct ConcurrentHashtable {
+    ConcurrentHashtableTable* volatile table;
+    ConcurrentHashtableTable* retired;
+    usize length;
+    volatile u32 lock;
+};
+
+internal ConcurrentHashtableTable* nb_concurrent_hashtable_alloc_table(usize capacity) {
+    usize size = sizeof(ConcurrentHashtableTable) + capacity * sizeof(ConcurrentHashtableSlot);
+    ConcurrentHashtableTable* table = nb_hashtable_alloc(null, size, NB_DEFAULT_ALIGNMENT);
+    if (table == null) {
+        return null;
+    }
+    memset(table, 0, size);
+    table->capacity = capacity;
+    return table;
+}
+
+internal NB_FORCE_INLINE usize nb_concurrent_hashtable_table_size(ConcurrentHashtableTable* table) {
+    return sizeof(ConcurrentHashtableTable) + table->capacity * sizeof(ConcurrentHashtableSlot);
+}
+
+ConcurrentHashtable* nb_concurrent_hashtable_create(void) {
+    ConcurrentHashtable* ht = nb_hashtable_alloc(null, sizeof(ConcurrentHashtable), NB_DEFAULT_ALIGNMENT);
+    if (ht == null) {
+        return null;
+    }
+    ht->table = nb_concurrent_hashtable_alloc_table(NB_CONCURRENT_HASHTABLE_INITIAL_CAPACITY);
+    if (ht->table == null) {
+        nb_free(ht);
+        return null;
+    }
+    ht->retired = null;
+    ht->length = 0;
+    ht->lock = 0;
+    return ht;
+}
+
+void nb_concurrent_hashtable_destroy(ConcurrentHashtable* ht) {
+    nb_concurrent_hashtable_reclaim(ht);
+    ConcurrentHashtableTable* table = ht->table;
+    for (usize i = 0; i < table->capacity; i++) {
+        if (table->slots[i].entry != null) {
+            nb_free(table->slots[i].entry);
+        }
+    }
+    nb_free(table);
+    nb_free(ht);
+}
+
+void* nb_concurrent_hashtable_get(ConcurrentHashtable* ht, const char* key) {
+    return nb_concurrent_hashtable_get_n(ht, key, strlen(key));
+}
+
+void* nb_concurrent_hashtable_get_n(ConcurrentHashtable* ht, const char* key, usize length) {
+    ConcurrentHashtableTable* table = nb_atomic_load_ptr((void* volatile*)&ht->table);
+    u64 hash = nb_hashtable_hash_key(key, length);
+    usize mask = table->capacity - 1;
+    for (usize i = (usize)hash & mask;; i = (i + 1) & mask) {
+        ConcurrentHashtableSlot* slot = &table->slots[i];
+        ConcurrentHashtableEntry* entry = nb_atomic_load_ptr((void* volatile*)&slot->entry);
+        if (entry == null) {
+            return null;
+        }
+        if (slot->hash == hash && entry->length == length && memcmp(entry->key, key, length) == 0) {
+            return nb_atomic_load_ptr(&entry->value);
+        }
+    }
+}
+
+// Only called by writers holding the lock
+internal ConcurrentHashtableSlot* nb_concurrent_hashtable_probe(
+    ConcurrentHashtableTable* table, 
+    const char* key, 
+    usize length, 
+    u64 hash) 
+{
+    usize mask = table->capacity - 1;
+    for (usize i = (usize)hash & mask;; i = (i + 1) & mask) {
+        ConcurrentHashtableSlot* slot = &table->slots[i];
+        ConcurrentHashtableEntry* entry = slot->entry;
+        if (entry == null || 
+            (slot->hash == hash && entry->length == length && memcmp(entry->key, key, length) == 0)) {
+            return slot;
+        }
+    }
+}
+
+internal b32 nb_concurrent_hashtable_expand(ConcurrentHashtable* ht) {
+    ConcurrentHashtableTable* old_table = ht->table;
+    ConcurrentHashtableTable* new_table = nb_concurrent_hashtable_alloc_table(old_table->capacity * 2);
+    if (new_table == null) {
+        return false;
+    }
+
+    // The new table isn't visible yet so plain stores are fine here
+    usize mask = new_table->capacity - 1;
+    for (usize i = 0; i < old_table->capacity; i++) {
+        ConcurrentHashtableSlot* slot = &old_table->slots[i];
+        if (slot->entry == null) {
+            continue;
+        }
+        usize index = (usize)slot->hash & mask;
+        while (new_table->slots[index].entry != null) {
+            index = (index + 1) & mask;
+        }
+        new_table->slots[index] = *slot;
+    }
+
+    nb_atomic_store_ptr((void* volatile*)&ht->table, new_table);
+    old_table->next_retired = ht->retired;
+    ht->retired = old_table;
+    return true;
+}
+
+// Returns the entry for the key, inserting it if missing. Called with the lock held.
+internal ConcurrentHashtableEntry* nb_concurrent_hashtable_insert(
+    ConcurrentHashtable* ht, 
+    const char* key, 
+    usize length, 
+    void* value) 
+{
+    u64 hash = nb_hashtable_hash_key(key, length);
+    ConcurrentHashtableSlot* slot = nb_concurrent_hashtable_probe(ht->table, key, length, hash);
+    if (slot->entry != null) {
+        nb_atomic_store_ptr(&slot->entry->value, value);
+        return slot->entry;
+    }
+
+    if (ht->length + 1 > NB_CONCURRENT_HASHTABLE_MAX_LOAD(ht->table->capacity)) {
+        if (!nb_concurrent_hashtable_expand(ht)) {
+            return null;
+        }
+        slot = nb_concurrent_hashtable_probe(ht->table, key, length, hash);
+    }
+
+    ConcurrentHashtableEntry* entry = nb_hashtable_alloc(null, 
+        sizeof(ConcurrentHashtableEntry) + length + 1, NB_DEFAULT_ALIGNMENT);
+    if (entry == null) {
+        return null;
+    }
+    entry->value = value;
+    entry->length = length;
+    memcpy(entry->key, key, length);
+    entry->key[length] = '\0';
+
+    slot->hash = hash;
+    nb_atomic_store_ptr((void* volatile*)&slot->entry, entry);
+    ht->length++;
+    return entry;
+}
+
+const char* nb_concurrent_hashtable_set(ConcurrentHashtable* ht, const char* key, void* value) {
+    NB_ASSERT(value != null);
+    nb_spin_lock(&ht->lock);
+    ConcurrentHashtableEntry* entry = nb_concurrent_hashtable_insert(ht, key, strlen(key), value);
+    nb_spin_unlock(&ht->lock);
+    return entry != null ? entry->key : null;
+}
+
+usize nb_concurrent_hashtable_length(ConcurrentHashtable* ht) {
+    nb_spin_lock(&ht->lock);
+    usize length = ht->length;
+    nb_spin_unlock(&ht->lock);
+    return length;
+}
+
+usize nb_concurrent_hashtable_reclaim(ConcurrentHashtable* ht) {
+    nb_spin_lock(&ht->lock);
+    ConcurrentHashtableTable* retired = ht->retired;
+    ht->retired = null;
+    nb_spin_unlock(&ht->lock);
+
+    usize released = 0;
+    while (retired != null) {
+        ConcurrentHashtableTable* next = retired->next_retired;
+        released += nb_concurrent_hashtable_table_size(retired);
+        nb_free(retired);
+        retired = next;
+    }
+    return released;
+}
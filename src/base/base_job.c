@@ -0,0 +1,367 @@
+#include "base.h"
+#include <string.h>
+
+// Deques are Chase-Lev (https://www.dre.vanderbilt.edu/~schmidt/PDF/work-stealing-dequeue.pdf)
+// with a fixed capacity. Entries are read by thieves before their CAS on
+// top decides who owns the job, so every field is accessed atomically and
+// a thief that loses the race just drops what it read.
+
+#define NB_JOB_QUEUE_MASK   (NB_JOB_QUEUE_CAPACITY - 1)
+
+// Failed attempts to find a job before an idle worker goes to sleep
+#define NB_JOB_SPIN_COUNT   64
+
+// func is kept as an integer, ISO C has no conversion between function and
+// object pointers
+typedef struct JobQueueEntry {
+    volatile u64 func;
+    void* volatile data;
+    void* volatile counter;
+} JobQueueEntry;
+
+// top is written by thieves and bottom by the owner, keep them apart
+typedef struct JobWorker {
+    volatile u64 top;
+    u8 _pad0[NB_CACHE_LINE_SIZE - sizeof(u64)];
+    volatile u64 bottom;
+    u8 _pad1[NB_CACHE_LINE_SIZE - sizeof(u64)];
+
+    JobQueueEntry* entries;
+    JobSystem* js;
+    u32 index;
+    u32 rng;
+    PlatformThread thread;
+} JobWorker;
+
+struct JobSystem {
+    JobWorker* workers;
+    u32 worker_count;
+    b32 pin_threads;
+    // The creator runs as worker 0, its affinity comes back on destroy
+    PlatformAffinity creator_affinity;
+    // Workers wait for it before touching worker_count or other deques
+    volatile u32 started;
+    volatile u32 running;
+    // Idle workers sleep on wake_signal, pushers bump it when any are asleep
+    volatile u32 sleepers;
+    volatile u32 wake_signal;
+};
+
+typedef struct JobEntry {
+    JobFunc func;
+    void* data;
+    JobCounter* counter;
+} JobEntry;
+
+global NB_THREAD_LOCAL JobWorker* nb_job_current_worker = null;
+
+// Deque --------------------------------------------------------------
+
+internal b32 nb_job_queue_push(JobWorker* worker, Job* job, JobCounter* counter) {
+    u64 bottom = worker->bottom;
+    u64 top = nb_atomic_load_u64(&worker->top);
+    if (bottom - top >= NB_JOB_QUEUE_CAPACITY) {
+        return false;
+    }
+
+    JobQueueEntry* entry = &worker->entries[bottom & NB_JOB_QUEUE_MASK];
+    nb_atomic_store_u64(&entry->func, (u64)(uptr)job->func);
+    nb_atomic_store_ptr(&entry->data, job->data);
+    nb_atomic_store_ptr(&entry->counter, counter);
+    nb_atomic_store_u64(&worker->bottom, bottom + 1);
+    return true;
+}
+
+internal NB_FORCE_INLINE void nb_job_queue_read(JobQueueEntry* entry, JobEntry* out) {
+    out->func = (JobFunc)(uptr)nb_atomic_load_u64(&entry->func);
+    out->data = nb_atomic_load_ptr(&entry->data);
+    out->counter = nb_atomic_load_ptr(&entry->counter);
+}
+
+internal b32 nb_job_queue_pop(JobWorker* worker, JobEntry* out) {
+    u64 bottom = worker->bottom - 1;
+    nb_atomic_store_u64(&worker->bottom, bottom);
+    // The store to bottom has to be visible before top is read, or a thief
+    // and the owner could both take the last job
+    nb_atomic_fence();
+    u64 top = nb_atomic_load_u64(&worker->top);
+
+    if ((i64)(bottom - top) < 0) {
+        nb_atomic_store_u64(&worker->bottom, bottom + 1);
+        return false;
+    }
+
+    nb_job_queue_read(&worker->entries[bottom & NB_JOB_QUEUE_MASK], out);
+    if (bottom != top) {
+        return true;
+    }
+
+    // Last job, race the thieves for it
+    b32 won = nb_atomic_cas_u64(&worker->top, top, top + 1);
+    nb_atomic_store_u64(&worker->bottom, bottom + 1);
+    return won;
+}
+
+internal b32 nb_job_queue_steal(JobWorker* worker, JobEntry* out) {
+    u64 top = nb_atomic_load_u64(&worker->top);
+    nb_atomic_fence();
+    u64 bottom = nb_atomic_load_u64(&worker->bottom);
+    if ((i64)(bottom - top) <= 0) {
+        return false;
+    }
+
+    nb_job_queue_read(&worker->entries[top & NB_JOB_QUEUE_MASK], out);
+    return nb_atomic_cas_u64(&worker->top, top, top + 1);
+}
+
+// Scheduling ---------------------------------------------------------
+
+internal NB_FORCE_INLINE void nb_job_execute(JobEntry* job) {
+    job->func(job->data);
+    if (job->counter != null) {
+        nb_atomic_add_u32(&job->counter->value, (u32)-1);
+    }
+}
+
+internal b32 nb_job_find(JobWorker* worker, JobEntry* out) {
+    if (nb_job_queue_pop(worker, out)) {
+        return true;
+    }
+
+    // Steal starting from a random victim so thieves spread out
+    JobSystem* js = worker->js;
+    worker->rng ^= worker->rng << 13;
+    worker->rng ^= worker->rng >> 17;
+    worker->rng ^= worker->rng << 5;
+    u32 start = worker->rng % js->worker_count;
+    for (u32 i = 0; i < js->worker_count; i++) {
+        JobWorker* victim = &js->workers[(start + i) % js->worker_count];
+        if (victim != worker && nb_job_queue_steal(victim, out)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+internal void nb_job_notify(JobSystem* js, usize count) {
+    // Orders the pushes before the sleepers load, pairs with the increment
+    // of sleepers in nb_job_worker_proc
+    nb_atomic_fence();
+    if (nb_atomic_load_u32(&js->sleepers) == 0) {
+        return;
+    }
+    nb_atomic_add_u32(&js->wake_signal, 1);
+    if (count > 1) {
+        platform_futex_wake_all(&js->wake_signal);
+    } else {
+        platform_futex_wake_one(&js->wake_signal);
+    }
+}
+
+internal void nb_job_worker_proc(void* data) {
+    JobWorker* worker = data;
+    JobSystem* js = worker->js;
+    nb_job_current_worker = worker;
+    if (js->pin_threads) {
+        platform_thread_set_affinity(worker->index % platform_cpu_count());
+    }
+#ifdef NB_PROFILER_ENABLED
+    char name[32];
+    snprintf(name, sizeof(name), "job worker %u", worker->index);
+    nb_profiler_set_thread_name(name);
+#endif
+    while (!nb_atomic_load_u32(&js->started)) {
+        platform_futex_wait(&js->started, false);
+    }
+
+    JobEntry job;
+    u32 failures = 0;
+    while (nb_atomic_load_u32(&js->running)) {
+        if (nb_job_find(worker, &job)) {
+            nb_job_execute(&job);
+            failures = 0;
+            continue;
+        }
+        if (++failures < NB_JOB_SPIN_COUNT) {
+            NB_CPU_PAUSE();
+            continue;
+        }
+
+        // Register as a sleeper before the last look so a push either sees
+        // us or we see its job
+        u32 signal = nb_atomic_load_u32(&js->wake_signal);
+        nb_atomic_add_u32(&js->sleepers, 1);
+        if (nb_job_find(worker, &job)) {
+            nb_atomic_add_u32(&js->sleepers, (u32)-1);
+            nb_job_execute(&job);
+        } else {
+            if (nb_atomic_load_u32(&js->running)) {
+                platform_futex_wait(&js->wake_signal, signal);
+            }
+            nb_atomic_add_u32(&js->sleepers, (u32)-1);
+        }
+        failures = 0;
+    }
+
+    nb_job_current_worker = null;
+    nb_concurrent_pool_release_thread();
+    nb_scratch_release_thread();
+}
+
+// Job System ---------------------------------------------------------
+
+JobSystem* nb_job_system_create(Arena* arena, u32 worker_count, b32 pin_threads) {
+    NB_ASSERT_MSG(nb_job_current_worker == null, "Thread already belongs to a job system");
+    if (worker_count == 0) {
+        worker_count = platform_cpu_count();
+    }
+
+    JobSystem* js = nb_arena_alloc(arena, sizeof(JobSystem));
+    JobWorker* workers = nb_arena_alloc_aligned(arena, sizeof(JobWorker) * worker_count, NB_CACHE_LINE_SIZE);
+    if (js == null || workers == null) {
+        return null;
+    }
+    memset(js, 0, sizeof(JobSystem));
+    memset(workers, 0, sizeof(JobWorker) * worker_count);
+    js->workers = workers;
+    js->pin_threads = pin_threads;
+    js->running = true;
+
+    for (u32 i = 0; i < worker_count; i++) {
+        workers[i].entries = nb_arena_alloc_aligned(arena, 
+            sizeof(JobQueueEntry) * NB_JOB_QUEUE_CAPACITY, NB_CACHE_LINE_SIZE);
+        if (workers[i].entries == null) {
+            return null;
+        }
+        workers[i].js = js;
+        workers[i].index = i;
+        workers[i].rng = 0x9E3779B9u * (i + 1);
+    }
+
+    nb_job_current_worker = &workers[0];
+    if (js->pin_threads) {
+        // Only pin when the creator's affinity can be put back
+        js->pin_threads = platform_thread_save_affinity(&js->creator_affinity);
+    }
+    if (js->pin_threads) {
+        platform_thread_set_affinity(0);
+    }
+    u32 spawned = 1;
+    while (spawned < worker_count) {
+        if (!platform_thread_create(&workers[spawned].thread, nb_job_worker_proc, &workers[spawned])) {
+            // Run with the workers we got, nobody steals from the rest
+            break;
+        }
+        spawned++;
+    }
+    js->worker_count = spawned;
+    nb_atomic_store_u32(&js->started, true);
+    platform_futex_wake_all(&js->started);
+    return js;
+}
+
+void nb_job_system_destroy(JobSystem* js) {
+    NB_ASSERT(nb_job_current_worker == &js->workers[0]);
+    nb_atomic_store_u32(&js->running, false);
+    nb_atomic_add_u32(&js->wake_signal, 1);
+    platform_futex_wake_all(&js->wake_signal);
+    for (u32 i = 1; i < js->worker_count; i++) {
+        platform_thread_join(&js->workers[i].thread);
+    }
+    if (js->pin_threads) {
+        platform_thread_restore_affinity(&js->creator_affinity);
+    }
+    nb_job_current_worker = null;
+}
+
+u32 nb_job_system_worker_count(JobSystem* js) {
+    return js->worker_count;
+}
+
+u32 nb_job_worker_index(void) {
+    return nb_job_current_worker ? nb_job_current_worker->index : NB_JOB_WORKER_NONE;
+}
+
+void nb_job_run(JobSystem* js, Job* jobs, usize count, JobCounter* counter) {
+    JobWorker* worker = nb_job_current_worker;
+    NB_ASSERT_MSG(worker != null && worker->js == js, "Jobs can only be submitted from a worker");
+
+    if (counter != null) {
+        nb_atomic_add_u32(&counter->value, (u32)count);
+    }
+    for (usize i = 0; i < count; i++) {
+        if (!nb_job_queue_push(worker, &jobs[i], counter)) {
+            JobEntry job = { jobs[i].func, jobs[i].data, counter };
+            nb_job_execute(&job);
+        }
+    }
+    nb_job_notify(js, count);
+}
+
+void nb_job_wait(JobSystem* js, JobCounter* counter) {
+    JobWorker* worker = nb_job_current_worker;
+    NB_ASSERT(worker != null && worker->js == js);
+
+    JobEntry job;
+    u32 failures = 0;
+    while (nb_atomic_load_u32(&counter->value) != 0) {
+        if (nb_job_find(worker, &job)) {
+            nb_job_execute(&job);
+            failures = 0;
+        } else if (++failures < NB_JOB_SPIN_COUNT) {
+            NB_CPU_PAUSE();
+        } else {
+            // The remaining jobs are running elsewhere
+            platform_thread_yield();
+        }
+    }
+}
+
+// Parallel For -------------------------------------------------------
+
+// Every job claims batches from the shared cursor until none are left, so
+// workers that finish early take over the remaining batches
+typedef struct JobParallelFor {
+    JobRangeFunc func;
+    void* data;
+    usize count;
+    usize batch_size;
+    volatile u64 next;
+} JobParallelFor;
+
+internal void nb_job_parallel_for_proc(void* data) {
+    JobParallelFor* pf = data;
+    for (;;) {
+        u64 start = nb_atomic_add_u64(&pf->next, pf->batch_size);
+        if (start >= pf->count) {
+            return;
+        }
+        pf->func(pf->data, (usize)start, NB_MIN((usize)start + pf->batch_size, pf->count));
+    }
+}
+
+void nb_job_parallel_for(JobSystem* js, usize count, usize batch_size, JobRangeFunc func, void* data) {
+    if (count == 0) {
+        return;
+    }
+    if (batch_size == 0) {
+        // A few batches per worker balances uneven items without much overhead
+        batch_size = NB_MAX(count / ((usize)js->worker_count * 4), 1);
+    }
+
+    JobParallelFor pf;
+    pf.func = func;
+    pf.data = data;
+    pf.count = count;
+    pf.batch_size = batch_size;
+    pf.next = 0;
+
+    usize batch_count = (count + batch_size - 1) / batch_size;
+    usize job_count = NB_MIN(batch_count, (usize)js->worker_count);
+    Job job = { nb_job_parallel_for_proc, &pf };
+    JobCounter counter = {0};
+    for (usize i = 0; i < job_count; i++) {
+        nb_job_run(js, &job, 1, &counter);
+    }
+    nb_job_wait(js, &counter);
+}
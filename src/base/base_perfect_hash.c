@@ -0,0 +1,321 @@
+// Hash and displace (CHD, http://cmph.sourceforge.net/papers/esa09.pdf):
+// keys are split into buckets of about three, then buckets are placed
+// largest first by trying displacements until all their keys land on free
+// slots. Buckets holding a single key skip the search and store the slot
+// directly, flagged by the top bit.
+
+#include "base.h"
+#include <string.h>
+
+#define NB_PERFECT_HASHTABLE_BUCKET_SIZE        3
+#define NB_PERFECT_HASHTABLE_DIRECT             0x80000000u
+#define NB_PERFECT_HASHTABLE_MAX_DISPLACEMENT   (1u << 22)
+#define NB_PERFECT_HASHTABLE_MAX_SEEDS          16
+
+typedef struct PerfectHashtableSlot {
+    u64 hash;
+    u32 key_offset;     // From the start of the string pool
+    u32 key_length;
+    u64 value;
+} PerfectHashtableSlot;
+
+struct PerfectHashtable {
+    u32 magic;
+    u32 version;
+    u64 seed;
+    u32 count;
+    u32 bucket_count;
+    u64 size;           // Whole blob, header included
+    // u32 displacements[bucket_count], padded to 8 bytes
+    // PerfectHashtableSlot slots[count]
+    // char string_pool[]
+};
+
+internal NB_FORCE_INLINE usize nb_perfect_hashtable_slots_offset(u32 bucket_count) {
+    return (sizeof(PerfectHashtable) + bucket_count * sizeof(u32) + 7) & ~(usize)7;
+}
+
+// Maps the high 32 bits of a hash onto [0, range) without a division
+internal NB_FORCE_INLINE u32 nb_perfect_hashtable_reduce(u64 hash, u32 range) {
+    return (u32)(((hash >> 32) * range) >> 32);
+}
+
+internal NB_FORCE_INLINE u32 nb_perfect_hashtable_bucket(u64 hash, u32 bucket_count) {
+    return nb_perfect_hashtable_reduce(nb_hash_u64(hash), bucket_count);
+}
+
+internal NB_FORCE_INLINE u32 nb_perfect_hashtable_position(u64 hash, u32 displacement, u32 count) {
+    return nb_perfect_hashtable_reduce(nb_hash_u64(hash + displacement + 1), count);
+}
+
+// Builder --------------------------------------------------------------
+
+typedef struct PerfectHashtableKey {
+    const char* key;
+    usize length;
+    u64 hash;
+    u64 value;
+} PerfectHashtableKey;
+
+// Fills 'displacements' and 'slot_keys', false if some bucket couldn't be placed
+internal b32 nb_perfect_hashtable_place(
+    Arena* scratch,
+    PerfectHashtableKey* keys, 
+    u32 count, 
+    u32 bucket_count, 
+    u32* displacements, 
+    u32* slot_keys) 
+{
+    // Counting sort the keys by bucket
+    u32* bucket_start = nb_arena_alloc(scratch, (bucket_count + 1) * sizeof(u32));
+    u32* bucket_keys = nb_arena_alloc(scratch, count * sizeof(u32));
+    u32* order = nb_arena_alloc(scratch, bucket_count * sizeof(u32));
+    u8* taken = nb_arena_alloc(scratch, count);
+    if (!bucket_start || !bucket_keys || !order || !taken) {
+        return false;
+    }
+    memset(bucket_start, 0, (bucket_count + 1) * sizeof(u32));
+    memset(taken, 0, count);
+
+    u32 max_bucket_size = 0;
+    for (u32 i = 0; i < count; i++) {
+        bucket_start[nb_perfect_hashtable_bucket(keys[i].hash, bucket_count) + 1]++;
+    }
+    for (u32 b = 0; b < bucket_count; b++) {
+        max_bucket_size = NB_MAX(max_bucket_size, bucket_start[b + 1]);
+        bucket_start[b + 1] += bucket_start[b];
+    }
+    for (u32 i = 0; i < count; i++) {
+        u32 b = nb_perfect_hashtable_bucket(keys[i].hash, bucket_count);
+        bucket_keys[bucket_start[b]++] = i;
+    }
+    // The scatter moved every start to the next bucket's start, shift back
+    for (u32 b = bucket_count; b > 0; b--) {
+        bucket_start[b] = bucket_start[b - 1];
+    }
+    bucket_start[0] = 0;
+
+    // Largest buckets first while the table is still mostly empty
+    u32 ordered = 0;
+    for (u32 size = max_bucket_size; size > 0; size--) {
+        for (u32 b = 0; b < bucket_count; b++) {
+            if (bucket_start[b + 1] - bucket_start[b] == size) {
+                order[ordered++] = b;
+            }
+        }
+    }
+
+    for (u32 b = 0; b < bucket_count; b++) {
+        displacements[b] = 0;
+    }
+
+    u32 positions[64];
+    u32 next_free = 0;
+    for (u32 o = 0; o < ordered; o++) {
+        u32 b = order[o];
+        u32* members = bucket_keys + bucket_start[b];
+        u32 size = bucket_start[b + 1] - bucket_start[b];
+
+        if (size == 1) {
+            while (taken[next_free]) {
+                next_free++;
+            }
+            taken[next_free] = 1;
+            slot_keys[next_free] = members[0];
+            displacements[b] = NB_PERFECT_HASHTABLE_DIRECT | next_free;
+            continue;
+        }
+
+        if (size > sizeof(positions) / sizeof(positions[0])) {
+            return false;
+        }
+
+        b32 placed = false;
+        for (u32 d = 0; d < NB_PERFECT_HASHTABLE_MAX_DISPLACEMENT && !placed; d++) {
+            placed = true;
+            for (u32 k = 0; k < size && placed; k++) {
+                u32 pos = nb_perfect_hashtable_position(keys[members[k]].hash, d, count);
+                if (taken[pos]) {
+                    placed = false;
+                }
+                for (u32 j = 0; j < k && placed; j++) {
+                    if (positions[j] == pos) {
+                        placed = false;
+                    }
+                }
+                positions[k] = pos;
+            }
+            if (placed) {
+                for (u32 k = 0; k < size; k++) {
+                    taken[positions[k]] = 1;
+                    slot_keys[positions[k]] = members[k];
+                }
+                displacements[b] = d;
+            }
+        }
+        if (!placed) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void* nb_perfect_hashtable_build(
+    Hashtable* ht, 
+    Arena* arena, 
+    PerfectHashtableValueFn to_value, 
+    void* user_data, 
+    usize* out_size) 
+{
+    usize length = nb_hashtable_length(ht);
+    if (length > NB_PERFECT_HASHTABLE_DIRECT - 1) {
+        return null;
+    }
+    u32 count = (u32)length;
+    u32 bucket_count = count / NB_PERFECT_HASHTABLE_BUCKET_SIZE + 1;
+
+    TempArena scratch = nb_scratch_begin(&arena, 1);
+    void* result = null;
+
+    PerfectHashtableKey* keys = nb_arena_alloc(scratch.arena, count * sizeof(PerfectHashtableKey));
+    u32* displacements = nb_arena_alloc(scratch.arena, bucket_count * sizeof(u32));
+    u32* slot_keys = nb_arena_alloc(scratch.arena, count * sizeof(u32));
+    if ((count && (!keys || !slot_keys)) || !displacements) {
+        nb_scratch_end(scratch);
+        return null;
+    }
+
+    usize pool_size = 0;
+    HashtableIterator it = nb_hashtable_iterator(ht);
+    for (u32 i = 0; nb_hashtable_next(&it); i++) {
+        keys[i].key = it.key;
+        keys[i].length = strlen(it.key);
+        keys[i].value = to_value ? to_value(it.key, it.value, user_data) : (u64)(uptr)it.value;
+        pool_size += keys[i].length + 1;
+    }
+    if (pool_size > 0xFFFFFFFFu) {
+        nb_scratch_end(scratch);
+        return null;
+    }
+
+    // Identical 64 bit hashes can never be separated, a new seed fixes those too
+    u64 seed = 0;
+    b32 placed = false;
+    for (u32 attempt = 0; attempt < NB_PERFECT_HASHTABLE_MAX_SEEDS && !placed; attempt++) {
+        seed = nb_hash_u64(attempt);
+        for (u32 i = 0; i < count; i++) {
+            keys[i].hash = nb_hash_bytes(keys[i].key, keys[i].length, seed);
+        }
+        usize marker = nb_arena_get_marker(scratch.arena);
+        placed = nb_perfect_hashtable_place(scratch.arena, keys, count, bucket_count, displacements, slot_keys);
+        nb_arena_free_to_marker(scratch.arena, marker);
+    }
+
+    if (placed) {
+        usize slots_offset = nb_perfect_hashtable_slots_offset(bucket_count);
+        usize pool_offset = slots_offset + count * sizeof(PerfectHashtableSlot);
+        usize size = (pool_offset + pool_size + 7) & ~(usize)7;
+
+        u8* blob = nb_arena_alloc_aligned(arena, size, 8);
+        if (blob) {
+            memset(blob, 0, size);
+            PerfectHashtable* header = (PerfectHashtable*)blob;
+            header->magic = NB_PERFECT_HASHTABLE_MAGIC;
+            header->version = NB_PERFECT_HASHTABLE_VERSION;
+            header->seed = seed;
+            header->count = count;
+            header->bucket_count = bucket_count;
+            header->size = size;
+            memcpy(blob + sizeof(PerfectHashtable), displacements, bucket_count * sizeof(u32));
+
+            PerfectHashtableSlot* slots = (PerfectHashtableSlot*)(blob + slots_offset);
+            char* pool = (char*)(blob + pool_offset);
+            u32 pool_used = 0;
+            for (u32 s = 0; s < count; s++) {
+                PerfectHashtableKey* key = &keys[slot_keys[s]];
+                slots[s].hash = key->hash;
+                slots[s].key_offset = pool_used;
+                slots[s].key_length = (u32)key->length;
+                slots[s].value = key->value;
+                memcpy(pool + pool_used, key->key, key->length + 1);
+                pool_used += (u32)key->length + 1;
+            }
+
+            *out_size = size;
+            result = blob;
+        }
+    }
+
+    nb_scratch_end(scratch);
+    return result;
+}
+
+// Queries --------------------------------------------------------------
+
+PerfectHashtable* nb_perfect_hashtable_open(const void* data, usize size) {
+    const PerfectHashtable* ph = data;
+    if (size < sizeof(PerfectHashtable) || ((uptr)data & 7) != 0) {
+        return null;
+    }
+    if (ph->magic != NB_PERFECT_HASHTABLE_MAGIC || ph->version != NB_PERFECT_HASHTABLE_VERSION) {
+        return null;
+    }
+    if (ph->size > size || ph->bucket_count == 0) {
+        return null;
+    }
+    u64 pool_offset = nb_perfect_hashtable_slots_offset(ph->bucket_count) + 
+        (u64)ph->count * sizeof(PerfectHashtableSlot);
+    if (pool_offset > ph->size) {
+        return null;
+    }
+
+    // Checking every slot keeps a truncated or corrupt file from reading out of bounds
+    const u32* displacements = (const u32*)(ph + 1);
+    for (u32 b = 0; b < ph->bucket_count; b++) {
+        u32 d = displacements[b];
+        if ((d & NB_PERFECT_HASHTABLE_DIRECT) && (d & ~NB_PERFECT_HASHTABLE_DIRECT) >= ph->count) {
+            return null;
+        }
+    }
+    const PerfectHashtableSlot* slots = 
+        (const PerfectHashtableSlot*)((const u8*)data + nb_perfect_hashtable_slots_offset(ph->bucket_count));
+    u64 pool_size = ph->size - pool_offset;
+    for (u32 s = 0; s < ph->count; s++) {
+        if ((u64)slots[s].key_offset + slots[s].key_length >= pool_size) {
+            return null;
+        }
+    }
+    return (PerfectHashtable*)ph;
+}
+
+b32 nb_perfect_hashtable_get(PerfectHashtable* ph, const char* key, u64* out_value) {
+    return nb_perfect_hashtable_get_n(ph, key, strlen(key), out_value);
+}
+
+b32 nb_perfect_hashtable_get_n(PerfectHashtable* ph, const char* key, usize length, u64* out_value) {
+    if (ph->count == 0) {
+        return false;
+    }
+    u8* base = (u8*)ph;
+    u64 hash = nb_hash_bytes(key, length, ph->seed);
+    u32 d = ((u32*)(ph + 1))[nb_perfect_hashtable_bucket(hash, ph->bucket_count)];
+    u32 pos = (d & NB_PERFECT_HASHTABLE_DIRECT) 
+        ? d & ~NB_PERFECT_HASHTABLE_DIRECT 
+        : nb_perfect_hashtable_position(hash, d, ph->count);
+
+    usize slots_offset = nb_perfect_hashtable_slots_offset(ph->bucket_count);
+    PerfectHashtableSlot* slot = (PerfectHashtableSlot*)(base + slots_offset) + pos;
+    if (slot->hash != hash || slot->key_length != length) {
+        return false;
+    }
+    const char* pool = (const char*)(base + slots_offset + ph->count * sizeof(PerfectHashtableSlot));
+    if (memcmp(pool + slot->key_offset, key, length) != 0) {
+        return false;
+    }
+    *out_value = slot->value;
+    return true;
+}
+
+usize nb_perfect_hashtable_length(PerfectHashtable* ph) {
+    return ph->count;
+}
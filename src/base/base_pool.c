@@ -1,59 +1,124 @@
 #include "base.h"
+#include <string.h>
+
+// Chunks are linked newest first, slots that were never handed out are
+// bumped from the newest chunk and only recycled slots go on the free list.
+typedef struct PoolChunk {
+    struct PoolChunk* next;
+    u8* mem;
+    usize size;
+} PoolChunk;
 
 struct Pool {
-    void* mem;
+    Arena* arena;
+    PoolChunk* chunks;
     void* free_list_head;
+    u8* bump;
+    u8* bump_end;
     usize size;
     usize used_size;
     usize peak_size;
     usize object_count;
     usize object_size;
+    usize chunk_object_count;
+    usize align;
+    b32 is_growable;
+    b32 check_frees;    // Debug builds walk the chunks to validate frees
+#ifdef NB_TELEMETRY_ENABLED
+    MemoryTelemetry telemetry;
+#endif
 };
 
-Pool* nb_pool_create(Arena *a, usize size, usize count) {
-   return nb_pool_create_aligned(a, size, count, NB_DEFAULT_ALIGNMENT);
+internal PoolChunk* nb_pool_add_chunk(Pool* pool) {
+    usize bytes_needed = pool->object_size * pool->chunk_object_count;
+    MemoryTag previous_tag = NB_MEMORY_TAG_BEGIN(MEMORY_TAG_POOL);
+    PoolChunk* chunk = nb_arena_alloc(pool->arena, sizeof(PoolChunk));
+    u8* mem = chunk ? nb_arena_alloc_aligned(pool->arena, bytes_needed, pool->align) : null;
+    NB_MEMORY_TAG_END(previous_tag);
+    if (mem == null) {
+        return null;
+    }
+    chunk->mem = mem;
+    chunk->size = bytes_needed;
+    chunk->next = pool->chunks;
+    pool->chunks = chunk;
+
+    pool->bump = chunk->mem;
+    pool->bump_end = chunk->mem + bytes_needed;
+    pool->size += bytes_needed;
+    pool->object_count += pool->chunk_object_count;
+    return chunk;
 }
 
-Pool* nb_pool_create_aligned(Arena *a, usize size,  usize count, usize align) {
-    usize bytes_needed = 0;
-    void* current_ptr = null;
+internal Pool* nb_pool_init(Arena *a, usize size, usize count, usize align, b32 is_growable) {
     NB_ASSERT_MSG(size >= sizeof(uptr),
         "Pool allocator only supports objects bigger than the"
         "size of a pointer.");
-    bytes_needed = size * count;
-    
-    void* mem = nb_arena_alloc_aligned(a, sizeof(Pool) + bytes_needed, align);
-    Pool* pool = (Pool*)mem;
-    pool->mem = (u8*)mem + sizeof(Pool);
-    pool->free_list_head = pool->mem;
-    pool->size = bytes_needed;
+    NB_ASSERT(count > 0);
+
+    Pool* pool = nb_arena_alloc(a, sizeof(Pool));
+    if (pool == null) {
+        return null;
+    }
+    pool->arena = a;
+    pool->chunks = null;
+    pool->free_list_head = null;
+    pool->bump = null;
+    pool->bump_end = null;
+    pool->size = 0;
     pool->used_size = 0;
     pool->peak_size = 0;
-    pool->object_count = count;
+    pool->object_count = 0;
     pool->object_size = size;
+    pool->chunk_object_count = count;
+    pool->align = align;
+    pool->is_growable = is_growable;
+    pool->check_frees = true;
+#ifdef NB_TELEMETRY_ENABLED
+    memset(&pool->telemetry, 0, sizeof(pool->telemetry));
+#endif
 
-    // setup linked list of free ptrs
-    current_ptr = pool->free_list_head;
-    for (usize i = 0; i < pool->object_count - 1; i++) {
-        *(uptr*)current_ptr = (uptr)(current_ptr) + pool->object_size;
-        current_ptr = (void*)(*(uptr*)current_ptr);
+    if (nb_pool_add_chunk(pool) == null) {
+        return null;
     }
-    *(uptr*)current_ptr = (uptr)null;
-
     return pool;
 }
 
+Pool* nb_pool_create(Arena *a, usize size, usize count) {
+   return nb_pool_create_aligned(a, size, count, NB_DEFAULT_ALIGNMENT);
+}
+
+Pool* nb_pool_create_aligned(Arena *a, usize size,  usize count, usize align) {
+    return nb_pool_init(a, size, count, align, false);
+}
+
+Pool* nb_pool_create_growable(Arena *a, usize size, usize chunk_count) {
+    return nb_pool_create_growable_aligned(a, size, chunk_count, NB_DEFAULT_ALIGNMENT);
+}
+
+Pool* nb_pool_create_growable_aligned(Arena *a, usize size, usize chunk_count, usize align) {
+    return nb_pool_init(a, size, chunk_count, align, true);
+}
+
 void* nb_pool_alloc(Pool* pool) {
     void* allocated = null;
-    if (pool->free_list_head == null) {
-        // TODO:(Novel) Log error here
-        return null; 
+    if (pool->free_list_head != null) {
+        allocated = pool->free_list_head;
+        pool->free_list_head = *((void**)(pool->free_list_head));
+    } else {
+        if (pool->bump == pool->bump_end) {
+            if (!pool->is_growable || nb_pool_add_chunk(pool) == null) {
+                // TODO:(Novel) Log error here
+                return null; 
+            }
+        }
+        allocated = pool->bump;
+        pool->bump += pool->object_size;
     }
-    allocated = pool->free_list_head;
-    pool->free_list_head = *((void**)(pool->free_list_head));
 
     pool->used_size += pool->object_size;
     pool->peak_size = NB_MAX(pool->peak_size, pool->used_size);
+    NB_TELEMETRY_RECORD(&pool->telemetry, pool->object_size, 0);
 
     return allocated;
 }
@@ -66,24 +131,37 @@ internal b32 nb_pool_validate_ptr(Pool* pool, void* ptr) {
 
     uptr ptr_to_check = (uptr)ptr;
 
-    uptr start_buf = (uptr)pool->mem;
-    uptr end_buf = start_buf + pool->size;
-    b32 is_ptr_in_buf = (ptr_to_check >= start_buf) &&
-        (ptr_to_check < end_buf);
-    
-    ptrdiff offset = ptr_to_check - start_buf;
-    b32 isPtrAlligned =
-        (offset % pool->object_size) == 0;
+    for (PoolChunk* chunk = pool->chunks; chunk; chunk = chunk->next) {
+        uptr start_buf = (uptr)chunk->mem;
+        uptr end_buf = start_buf + chunk->size;
+        b32 is_ptr_in_buf = (ptr_to_check >= start_buf) &&
+            (ptr_to_check < end_buf);
+        if (!is_ptr_in_buf) {
+            continue;
+        }
+
+        ptrdiff offset = ptr_to_check - start_buf;
+        b32 isPtrAlligned =
+            (offset % pool->object_size) == 0;
+        b32 was_handed_out = (chunk != pool->chunks) || (ptr_to_check < (uptr)pool->bump);
 
-    return is_ptr_in_buf && isPtrAlligned;
+        return isPtrAlligned && was_handed_out;
+    }
+
+    return false;
 }  
 
+// The chunk walk is O(chunks), owners that can validate pointers cheaper
+// themselves (e.g. the size classes of nb_alloc) turn it off
+internal void nb_pool_set_free_check(Pool* pool, b32 enabled) {
+    pool->check_frees = enabled;
+}
 
 void nb_pool_free(Pool* pool, void* ptr) {
     #ifdef NB_BUILD_DEBUG
         // For debug builds we can take some time to check if
         // the free is valid.
-        NB_ASSERT_MSG(nb_pool_validate_ptr(pool, ptr),
+        NB_ASSERT_MSG(!pool->check_frees || nb_pool_validate_ptr(pool, ptr),
             "Pool Allocator: Invalid pointer free");
     #endif
 
@@ -100,3 +178,299 @@ usize nb_pool_used_memory(Pool* pool) {
 usize nb_pool_peak_memory(Pool* pool) {
     return pool->peak_size;
 }
+usize nb_pool_capacity(Pool* pool) {
+    return pool->object_count;
+}
+
+#ifdef NB_TELEMETRY_ENABLED
+MemoryTelemetry* nb_pool_telemetry(Pool* pool) {
+    return &pool->telemetry;
+}
+#endif
+
+// Concurrent Pool -----------------------------------------------------
+
+// The shared free list is a stack of batches. Slots are addressed by index + 1
+// so 0 means empty, the first word of a slot links slots within a batch and
+// the second links batches. The stack head packs a tag in its high 32 bits
+// that changes on every push/pop so a stale CAS can't succeed (ABA).
+//
+// Magazines can outlive their pool on threads that never touch it again, so
+// live pools are registered by a never reused id. A thread only returns
+// cached slots to a pool whose registry entry still holds the id, counting
+// itself in 'users' meanwhile so destroy can wait for it.
+struct ConcurrentPool {
+    u8* mem;
+    usize object_size;
+    u32 object_count;
+    u32 id;
+    u32 registry_index;
+    volatile u64 free_head;
+    volatile u32 bump;
+    volatile u64 used_size;
+    volatile u64 peak_size;
+};
+
+typedef struct ConcurrentPoolMagazine {
+    ConcurrentPool* pool;
+    u32 pool_id;            // 0 when unused
+    u32 registry_index;
+    u32 count;
+    void* slots[NB_POOL_MAGAZINE_CAPACITY];
+} ConcurrentPoolMagazine;
+
+typedef struct ConcurrentPoolRegistryEntry {
+    volatile u32 id;        // 0 when free
+    volatile u32 users;
+} ConcurrentPoolRegistryEntry;
+
+global volatile u32 nb_concurrent_pool_next_id = 1;
+global ConcurrentPoolRegistryEntry nb_concurrent_pool_registry[NB_CONCURRENT_POOL_MAX_COUNT];
+global NB_THREAD_LOCAL ConcurrentPoolMagazine nb_pool_magazines[NB_POOL_MAGAZINE_SLOTS];
+global NB_THREAD_LOCAL u32 nb_pool_magazine_last = 0;
+global NB_THREAD_LOCAL u32 nb_pool_magazine_evict = 0;
+
+ConcurrentPool* nb_concurrent_pool_create(Arena *a, usize size, usize count) {
+    return nb_concurrent_pool_create_aligned(a, size, count, NB_DEFAULT_ALIGNMENT);
+}
+
+ConcurrentPool* nb_concurrent_pool_create_aligned(Arena *a, usize size, usize count, usize align) {
+    NB_ASSERT_MSG(size >= sizeof(u64),
+        "Concurrent pool only supports objects of at least 8 bytes.");
+    NB_ASSERT_MSG(count < 0xFFFFFFFFu, "Concurrent pool supports up to 2^32 - 2 objects.");
+
+    ConcurrentPool* pool = nb_arena_alloc(a, sizeof(ConcurrentPool));
+    if (pool == null) {
+        return null;
+    }
+    pool->mem = nb_arena_alloc_aligned(a, size * count, align);
+    if (pool->mem == null) {
+        return null;
+    }
+    pool->object_size = size;
+    pool->object_count = (u32)count;
+    pool->id = nb_atomic_add_u32(&nb_concurrent_pool_next_id, 1);
+    pool->free_head = 0;
+    pool->bump = 0;
+    pool->used_size = 0;
+    pool->peak_size = 0;
+
+    for (u32 i = 0; i < NB_CONCURRENT_POOL_MAX_COUNT; i++) {
+        if (nb_atomic_cas_u32(&nb_concurrent_pool_registry[i].id, 0, pool->id)) {
+            pool->registry_index = i;
+            return pool;
+        }
+    }
+    // TODO:(Novel) Log error here
+    return null;
+}
+
+void nb_concurrent_pool_destroy(ConcurrentPool* pool) {
+    for (usize i = 0; i < NB_POOL_MAGAZINE_SLOTS; i++) {
+        if (nb_pool_magazines[i].pool_id == pool->id) {
+            nb_pool_magazines[i].pool = null;
+            nb_pool_magazines[i].pool_id = 0;
+            nb_pool_magazines[i].count = 0;
+        }
+    }
+
+    // Once the id is gone no thread starts returning slots, wait out the
+    // ones that already checked it
+    ConcurrentPoolRegistryEntry* entry = &nb_concurrent_pool_registry[pool->registry_index];
+    nb_atomic_exchange_u32(&entry->id, 0);
+    nb_atomic_fence();
+    while (nb_atomic_load_u32(&entry->users) != 0) {
+        NB_CPU_PAUSE();
+    }
+}
+
+internal NB_FORCE_INLINE volatile u32* nb_concurrent_pool_links(ConcurrentPool* pool, u32 index) {
+    return (volatile u32*)(pool->mem + (usize)(index - 1) * pool->object_size);
+}
+
+internal NB_FORCE_INLINE u32 nb_concurrent_pool_index(ConcurrentPool* pool, void* ptr) {
+    return (u32)(((u8*)ptr - pool->mem) / pool->object_size) + 1;
+}
+
+internal void nb_concurrent_pool_track(ConcurrentPool* pool, u32 count, b32 is_alloc) {
+    u64 bytes = (u64)count * pool->object_size;
+    if (!is_alloc) {
+        nb_atomic_add_u64(&pool->used_size, (u64)0 - bytes);
+        return;
+    }
+
+    u64 used = nb_atomic_add_u64(&pool->used_size, bytes) + bytes;
+    u64 peak = nb_atomic_load_u64(&pool->peak_size);
+    while (used > peak && !nb_atomic_cas_u64(&pool->peak_size, peak, used)) {
+        peak = nb_atomic_load_u64(&pool->peak_size);
+    }
+}
+
+// Pushes slots[0..count) onto the shared stack as a single batch
+internal void nb_concurrent_pool_push_batch(ConcurrentPool* pool, void** slots, u32 count) {
+    u32 first = nb_concurrent_pool_index(pool, slots[0]);
+    for (u32 i = 0; i < count; i++) {
+        u32 next = (i + 1 < count) ? nb_concurrent_pool_index(pool, slots[i + 1]) : 0;
+        nb_concurrent_pool_links(pool, nb_concurrent_pool_index(pool, slots[i]))[0] = next;
+    }
+
+    volatile u32* first_links = nb_concurrent_pool_links(pool, first);
+    for (;;) {
+        u64 head = nb_atomic_load_u64(&pool->free_head);
+        nb_atomic_store_u32(&first_links[1], (u32)head);
+        u64 new_head = (((head >> 32) + 1) << 32) | first;
+        if (nb_atomic_cas_u64(&pool->free_head, head, new_head)) {
+            break;
+        }
+        NB_CPU_PAUSE();
+    }
+    nb_concurrent_pool_track(pool, count, false);
+}
+
+// Pops a batch off the shared stack, falling back to never used slots
+internal u32 nb_concurrent_pool_pop_batch(ConcurrentPool* pool, void** slots) {
+    u32 count = 0;
+    for (;;) {
+        u64 head = nb_atomic_load_u64(&pool->free_head);
+        u32 first = (u32)head;
+        if (first == 0) {
+            break;
+        }
+        // The slot may be popped and reused under us, the tag makes the CAS fail then
+        u32 next_batch = nb_atomic_load_u32(&nb_concurrent_pool_links(pool, first)[1]);
+        u64 new_head = (((head >> 32) + 1) << 32) | next_batch;
+        if (nb_atomic_cas_u64(&pool->free_head, head, new_head)) {
+            for (u32 index = first; index != 0 && count < NB_POOL_MAGAZINE_BATCH;) {
+                slots[count++] = (void*)nb_concurrent_pool_links(pool, index);
+                index = nb_concurrent_pool_links(pool, index)[0];
+            }
+            break;
+        }
+        NB_CPU_PAUSE();
+    }
+
+    if (count == 0) {
+        u32 bump = nb_atomic_load_u32(&pool->bump);
+        while (bump < pool->object_count) {
+            u32 take = NB_MIN((u32)NB_POOL_MAGAZINE_BATCH, pool->object_count - bump);
+            if (nb_atomic_cas_u32(&pool->bump, bump, bump + take)) {
+                for (u32 i = 0; i < take; i++) {
+                    slots[count++] = pool->mem + (usize)(bump + i) * pool->object_size;
+                }
+                break;
+            }
+            bump = nb_atomic_load_u32(&pool->bump);
+        }
+    }
+
+    if (count > 0) {
+        nb_concurrent_pool_track(pool, count, true);
+    }
+    return count;
+}
+
+// Returns the magazine's slots to its pool, or drops them if the pool was destroyed
+internal void nb_concurrent_pool_flush_magazine(ConcurrentPoolMagazine* mag) {
+    ConcurrentPoolRegistryEntry* entry = &nb_concurrent_pool_registry[mag->registry_index];
+    nb_atomic_add_u32(&entry->users, 1);
+    nb_atomic_fence();
+    if (nb_atomic_load_u32(&entry->id) == mag->pool_id) {
+        while (mag->count > 0) {
+            u32 batch = NB_MIN(mag->count, (u32)NB_POOL_MAGAZINE_BATCH);
+            mag->count -= batch;
+            nb_concurrent_pool_push_batch(mag->pool, &mag->slots[mag->count], batch);
+        }
+    }
+    nb_atomic_add_u32(&entry->users, (u32)-1);
+
+    mag->pool = null;
+    mag->pool_id = 0;
+    mag->count = 0;
+}
+
+// Magazines are fully associative, a thread alternating between a few pools
+// keeps one per pool. Only a ninth pool evicts, round robin.
+internal ConcurrentPoolMagazine* nb_concurrent_pool_magazine_find(ConcurrentPool* pool) {
+    u32 free_index = NB_POOL_MAGAZINE_SLOTS;
+    for (u32 i = 0; i < NB_POOL_MAGAZINE_SLOTS; i++) {
+        ConcurrentPoolMagazine* mag = &nb_pool_magazines[i];
+        if (mag->pool_id == pool->id) {
+            nb_pool_magazine_last = i;
+            return mag;
+        }
+        if (mag->pool_id != 0 &&
+            nb_atomic_load_u32(&nb_concurrent_pool_registry[mag->registry_index].id) != mag->pool_id) {
+            // Its pool was destroyed, the slots are gone with it
+            mag->pool = null;
+            mag->pool_id = 0;
+            mag->count = 0;
+        }
+        if (mag->pool_id == 0 && free_index == NB_POOL_MAGAZINE_SLOTS) {
+            free_index = i;
+        }
+    }
+
+    if (free_index == NB_POOL_MAGAZINE_SLOTS) {
+        free_index = nb_pool_magazine_evict++ % NB_POOL_MAGAZINE_SLOTS;
+        nb_concurrent_pool_flush_magazine(&nb_pool_magazines[free_index]);
+    }
+    ConcurrentPoolMagazine* mag = &nb_pool_magazines[free_index];
+    mag->pool = pool;
+    mag->pool_id = pool->id;
+    mag->registry_index = pool->registry_index;
+    mag->count = 0;
+    nb_pool_magazine_last = free_index;
+    return mag;
+}
+
+internal NB_FORCE_INLINE ConcurrentPoolMagazine* nb_concurrent_pool_magazine(ConcurrentPool* pool) {
+    ConcurrentPoolMagazine* mag = &nb_pool_magazines[nb_pool_magazine_last];
+    if (mag->pool_id == pool->id) {
+        return mag;
+    }
+    return nb_concurrent_pool_magazine_find(pool);
+}
+
+void* nb_concurrent_pool_alloc(ConcurrentPool* pool) {
+    ConcurrentPoolMagazine* mag = nb_concurrent_pool_magazine(pool);
+    if (mag->count == 0) {
+        mag->count = nb_concurrent_pool_pop_batch(pool, mag->slots);
+        if (mag->count == 0) {
+            // TODO:(Novel) Log error here
+            return null;
+        }
+    }
+    return mag->slots[--mag->count];
+}
+
+void nb_concurrent_pool_free(ConcurrentPool* pool, void* ptr) {
+    #ifdef NB_BUILD_DEBUG
+        uptr start_buf = (uptr)pool->mem;
+        uptr end_buf = start_buf + (usize)pool->object_count * pool->object_size;
+        NB_ASSERT_MSG((uptr)ptr >= start_buf && (uptr)ptr < end_buf &&
+            ((uptr)ptr - start_buf) % pool->object_size == 0,
+            "Concurrent Pool Allocator: Invalid pointer free");
+    #endif
+
+    ConcurrentPoolMagazine* mag = nb_concurrent_pool_magazine(pool);
+    if (mag->count == NB_POOL_MAGAZINE_CAPACITY) {
+        mag->count -= NB_POOL_MAGAZINE_BATCH;
+        nb_concurrent_pool_push_batch(pool, &mag->slots[mag->count], NB_POOL_MAGAZINE_BATCH);
+    }
+    mag->slots[mag->count++] = ptr;
+}
+
+void nb_concurrent_pool_release_thread(void) {
+    for (usize i = 0; i < NB_POOL_MAGAZINE_SLOTS; i++) {
+        if (nb_pool_magazines[i].pool_id != 0) {
+            nb_concurrent_pool_flush_magazine(&nb_pool_magazines[i]);
+        }
+    }
+}
+
+usize nb_concurrent_pool_used_memory(ConcurrentPool* pool) {
+    return (usize)nb_atomic_load_u64(&pool->used_size);
+}
+usize nb_concurrent_pool_peak_memory(ConcurrentPool* pool) {
+    return (usize)nb_atomic_load_u64(&pool->peak_size);
+}
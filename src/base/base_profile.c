@@ -0,0 +1,252 @@
+#include "base.h"
+#include <string.h>
+
+#ifdef NB_PROFILER_ENABLED
+
+// A zone is written to its thread's ring when it ends. Open zones sit on a
+// small per thread stack that also sums the time of their children.
+
+#define NB_PROFILER_THREAD_NAME_SIZE 32
+
+typedef struct ProfileEvent {
+    const char* name;
+    u64 start;
+    u64 end;
+    u64 child_cycles;
+    u32 depth;
+} ProfileEvent;
+
+typedef struct ProfileOpenZone {
+    const char* name;
+    u64 start;
+    u64 child_cycles;
+} ProfileOpenZone;
+
+typedef struct ProfileThread {
+    ProfileEvent* events;
+    u64 written;                // Total events ever written, wraps around the ring
+    u32 depth;                  // Can exceed NB_PROFILER_MAX_DEPTH, deeper zones aren't recorded
+    u32 id;
+    char name[NB_PROFILER_THREAD_NAME_SIZE];
+    ProfileOpenZone stack[NB_PROFILER_MAX_DEPTH];
+} ProfileThread;
+
+typedef struct Profiler {
+    Arena* arena;
+    u64 start_cycles;
+    ProfileThread* threads[NB_PROFILER_MAX_THREADS];
+    volatile u32 thread_count;
+    volatile u32 lock;
+} Profiler;
+
+global Profiler nb_profiler;
+global NB_THREAD_LOCAL ProfileThread* nb_profiler_thread = null;
+
+void nb_profiler_init(Arena* arena) {
+    memset(&nb_profiler, 0, sizeof(Profiler));
+    nb_profiler.arena = arena;
+    nb_profiler.start_cycles = platform_time_get_cycles();
+    // Calibrate now rather than in the middle of the first export
+    platform_time_get_cycle_frequency();
+}
+
+internal ProfileThread* nb_profiler_thread_register(void) {
+    NB_ASSERT_MSG(nb_profiler.arena != null, "nb_profiler_init wasn't called");
+    ProfileThread* thread = null;
+
+    nb_spin_lock(&nb_profiler.lock);
+    if (nb_profiler.thread_count < NB_PROFILER_MAX_THREADS) {
+        thread = nb_arena_alloc(nb_profiler.arena, sizeof(ProfileThread));
+        ProfileEvent* events = nb_arena_alloc(nb_profiler.arena, 
+            sizeof(ProfileEvent) * NB_PROFILER_RING_CAPACITY);
+        if (thread != null && events != null) {
+            memset(thread, 0, sizeof(ProfileThread));
+            thread->events = events;
+            thread->id = platform_thread_get_id();
+            snprintf(thread->name, NB_PROFILER_THREAD_NAME_SIZE, "thread %u", thread->id);
+            nb_profiler.threads[nb_profiler.thread_count++] = thread;
+        } else {
+            thread = null;
+        }
+    }
+    nb_spin_unlock(&nb_profiler.lock);
+
+    NB_ASSERT_MSG(thread != null, "Profiler out of threads or memory");
+    return thread;
+}
+
+internal NB_FORCE_INLINE ProfileThread* nb_profiler_get_thread(void) {
+    if (nb_profiler_thread == null) {
+        nb_profiler_thread = nb_profiler_thread_register();
+    }
+    return nb_profiler_thread;
+}
+
+void nb_profiler_begin(const char* name) {
+    ProfileThread* thread = nb_profiler_get_thread();
+    if (thread->depth < NB_PROFILER_MAX_DEPTH) {
+        ProfileOpenZone* zone = &thread->stack[thread->depth];
+        zone->name = name;
+        zone->child_cycles = 0;
+        zone->start = platform_time_get_cycles();
+    }
+    thread->depth++;
+}
+
+void nb_profiler_end(void) {
+    u64 end = platform_time_get_cycles();
+    ProfileThread* thread = nb_profiler_thread;
+    NB_ASSERT_MSG(thread != null && thread->depth > 0, "NB_PROFILE_END without a BEGIN");
+
+    u32 depth = --thread->depth;
+    if (depth >= NB_PROFILER_MAX_DEPTH) {
+        return;
+    }
+    ProfileOpenZone* zone = &thread->stack[depth];
+    u64 duration = end - zone->start;
+    if (depth > 0) {
+        thread->stack[depth - 1].child_cycles += duration;
+    }
+
+    ProfileEvent* event = &thread->events[thread->written % NB_PROFILER_RING_CAPACITY];
+    event->name = zone->name;
+    event->start = zone->start;
+    event->end = end;
+    event->child_cycles = zone->child_cycles;
+    event->depth = depth;
+    thread->written++;
+}
+
+void nb_profiler_set_thread_name(const char* name) {
+    ProfileThread* thread = nb_profiler_get_thread();
+    snprintf(thread->name, NB_PROFILER_THREAD_NAME_SIZE, "%s", name);
+}
+
+internal NB_FORCE_INLINE u64 nb_profiler_event_count(ProfileThread* thread) {
+    return NB_MIN(thread->written, (u64)NB_PROFILER_RING_CAPACITY);
+}
+
+// Oldest first
+internal NB_FORCE_INLINE ProfileEvent* nb_profiler_event(ProfileThread* thread, u64 index) {
+    u64 first = thread->written - nb_profiler_event_count(thread);
+    return &thread->events[(first + index) % NB_PROFILER_RING_CAPACITY];
+}
+
+// Aggregation ---------------------------------------------------------
+
+internal int nb_profiler_compare_total(const void* a, const void* b) {
+    f64 total_a = ((const ProfileZoneStats*)a)->total_seconds;
+    f64 total_b = ((const ProfileZoneStats*)b)->total_seconds;
+    return (total_a < total_b) - (total_a > total_b);
+}
+
+usize nb_profiler_aggregate(ProfileZoneStats* stats, usize max) {
+    f64 seconds_per_cycle = 1.0 / (f64)platform_time_get_cycle_frequency();
+    TempArena scratch = nb_scratch_begin(null, 0);
+    // Zone name -> index + 1 into 'stats'
+    HashtablePtr* indices = nb_hashtable_ptr_create(scratch.arena);
+    usize count = 0;
+
+    for (u32 t = 0; t < nb_profiler.thread_count; t++) {
+        ProfileThread* thread = nb_profiler.threads[t];
+        u64 event_count = nb_profiler_event_count(thread);
+        for (u64 e = 0; e < event_count; e++) {
+            ProfileEvent* event = nb_profiler_event(thread, e);
+            usize index = (usize)(uptr)nb_hashtable_ptr_get(indices, event->name);
+            if (index == 0) {
+                if (count == max) {
+                    continue;
+                }
+                index = ++count;
+                nb_hashtable_ptr_set(indices, scratch.arena, event->name, (void*)(uptr)index);
+                memset(&stats[index - 1], 0, sizeof(ProfileZoneStats));
+                stats[index - 1].name = event->name;
+            }
+
+            ProfileZoneStats* zone = &stats[index - 1];
+            f64 total = (f64)(event->end - event->start) * seconds_per_cycle;
+            zone->count++;
+            zone->total_seconds += total;
+            zone->self_seconds += (f64)(event->end - event->start - event->child_cycles) * seconds_per_cycle;
+            zone->max_seconds = NB_MAX(zone->max_seconds, total);
+        }
+    }
+
+    nb_scratch_end(scratch);
+    qsort(stats, count, sizeof(ProfileZoneStats), nb_profiler_compare_total);
+    return count;
+}
+
+void nb_profiler_report(void) {
+    ProfileZoneStats stats[256];
+    usize count = nb_profiler_aggregate(stats, 256);
+    platform_debug_print("Profile\n");
+    platform_debug_print("\t%-24s %10s %12s %12s %12s\n", "zone", "count", "total ms", "self ms", "max ms");
+    for (usize i = 0; i < count; i++) {
+        platform_debug_print("\t%-24s %10llu %12.3f %12.3f %12.3f\n", stats[i].name, 
+            (unsigned long long)stats[i].count, stats[i].total_seconds * 1000.0, 
+            stats[i].self_seconds * 1000.0, stats[i].max_seconds * 1000.0);
+    }
+}
+
+// Chrome Trace --------------------------------------------------------
+
+usize nb_profiler_chrome_json(char* buffer, usize size) {
+    f64 us_per_cycle = 1000000.0 / (f64)platform_time_get_cycle_frequency();
+    usize length = 0;
+    #define NB_PROFILER_JSON_APPEND(...) \
+        length += snprintf(length < size ? buffer + length : null, \
+                           length < size ? size - length : 0, __VA_ARGS__)
+
+    // Names are printed with %s, keep quotes and backslashes out of them
+    NB_PROFILER_JSON_APPEND("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[");
+    b32 first = true;
+    for (u32 t = 0; t < nb_profiler.thread_count; t++) {
+        ProfileThread* thread = nb_profiler.threads[t];
+        NB_PROFILER_JSON_APPEND("%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":%u,\"args\":{\"name\":\"%s\"}}",
+            first ? "" : ",", thread->id, thread->name);
+        first = false;
+
+        u64 event_count = nb_profiler_event_count(thread);
+        for (u64 e = 0; e < event_count; e++) {
+            ProfileEvent* event = nb_profiler_event(thread, e);
+            f64 ts = (f64)(i64)(event->start - nb_profiler.start_cycles) * us_per_cycle;
+            f64 dur = (f64)(event->end - event->start) * us_per_cycle;
+            NB_PROFILER_JSON_APPEND(",{\"name\":\"%s\",\"ph\":\"X\",\"pid\":0,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+                event->name, thread->id, ts, dur);
+        }
+    }
+    NB_PROFILER_JSON_APPEND("]}");
+
+    #undef NB_PROFILER_JSON_APPEND
+    return length;
+}
+
+b32 nb_profiler_write_chrome_trace(const char* filepath) {
+    TempArena scratch = nb_scratch_begin(null, 0);
+    usize size = nb_profiler_chrome_json(null, 0) + 1;
+    char* json = nb_arena_alloc(scratch.arena, size);
+    b32 result = false;
+    if (json != null) {
+        usize length = nb_profiler_chrome_json(json, size);
+        PlatformFile* file = platform_file_open_ex(filepath, 
+            PLATFORM_FILE_OPEN_WRITE | PLATFORM_FILE_OPEN_TRUNCATE);
+        if (file != null) {
+            result = platform_file_write(file, json, length) == length;
+            result = platform_file_close(file) && result;
+        }
+    }
+    nb_scratch_end(scratch);
+    return result;
+}
+
+void nb_profiler_reset(void) {
+    nb_spin_lock(&nb_profiler.lock);
+    for (u32 t = 0; t < nb_profiler.thread_count; t++) {
+        nb_profiler.threads[t]->written = 0;
+    }
+    nb_profiler.start_cycles = platform_time_get_cycles();
+    nb_spin_unlock(&nb_profiler.lock);
+}
+
+#endif
@@ -0,0 +1,97 @@
+#include "base.h"
+#include <string.h>
+
+#ifdef NB_TELEMETRY_ENABLED
+
+#define NB_TELEMETRY_RECORD(telemetry, size, padding) nb_telemetry_record((telemetry), (size), (padding))
+
+global NB_THREAD_LOCAL MemoryTag nb_memory_current_tag = MEMORY_TAG_UNTAGGED;
+
+global const char* nb_memory_tag_names[MEMORY_TAG_COUNT] = {
+    "untagged",
+    "pool",
+    "hashtable",
+    "scratch",
+    "scene",
+    "geometry",
+    "bvh",
+    "texture",
+    "render",
+};
+
+MemoryTag nb_memory_tag_set(MemoryTag tag) {
+    MemoryTag previous = nb_memory_current_tag;
+    nb_memory_current_tag = tag;
+    return previous;
+}
+
+const char* nb_memory_tag_name(MemoryTag tag) {
+    NB_ASSERT(tag < MEMORY_TAG_COUNT);
+    return nb_memory_tag_names[tag];
+}
+
+internal u32 nb_telemetry_bucket(usize size) {
+    if (size <= 16) {
+        return 0;
+    }
+    u32 log2_size = 64 - nb_count_leading_zeros64((u64)size - 1);
+    return NB_MIN(log2_size - 4, NB_TELEMETRY_HISTOGRAM_BUCKETS - 1);
+}
+
+internal void nb_telemetry_record(MemoryTelemetry* telemetry, usize size, usize padding) {
+    MemoryTagStats* stats = &telemetry->tags[nb_memory_current_tag];
+    stats->alloc_count++;
+    stats->bytes += size;
+    stats->padding += padding;
+    stats->histogram[nb_telemetry_bucket(size)]++;
+}
+
+void nb_telemetry_report(MemoryTelemetry* telemetry, const char* name) {
+    platform_debug_print("Memory telemetry: %s\n", name);
+    platform_debug_print("\t%-10s %12s %14s %14s %8s\n", 
+        "tag", "allocs", "bytes", "padding", "waste");
+    for (u32 i = 0; i < MEMORY_TAG_COUNT; i++) {
+        MemoryTagStats* stats = &telemetry->tags[i];
+        if (stats->alloc_count == 0) {
+            continue;
+        }
+        f64 waste = 100.0 * (f64)stats->padding / (f64)(stats->bytes + stats->padding);
+        platform_debug_print("\t%-10s %12llu %14llu %14llu %7.2f%%\n", nb_memory_tag_names[i],
+            (unsigned long long)stats->alloc_count, (unsigned long long)stats->bytes, 
+            (unsigned long long)stats->padding, waste);
+    }
+}
+
+usize nb_telemetry_json(MemoryTelemetry* telemetry, const char* name, char* buffer, usize size) {
+    usize length = 0;
+    #define NB_TELEMETRY_JSON_APPEND(...) \
+        length += snprintf(length < size ? buffer + length : null, \
+                           length < size ? size - length : 0, __VA_ARGS__)
+
+    NB_TELEMETRY_JSON_APPEND("{\"name\":\"%s\",\"tags\":[", name);
+    b32 first = true;
+    for (u32 i = 0; i < MEMORY_TAG_COUNT; i++) {
+        MemoryTagStats* stats = &telemetry->tags[i];
+        if (stats->alloc_count == 0) {
+            continue;
+        }
+        NB_TELEMETRY_JSON_APPEND("%s{\"tag\":\"%s\",\"allocs\":%llu,\"bytes\":%llu,\"padding\":%llu,\"histogram\":[",
+            first ? "" : ",", nb_memory_tag_names[i], (unsigned long long)stats->alloc_count, 
+            (unsigned long long)stats->bytes, (unsigned long long)stats->padding);
+        for (u32 b = 0; b < NB_TELEMETRY_HISTOGRAM_BUCKETS; b++) {
+            NB_TELEMETRY_JSON_APPEND("%s%llu", b ? "," : "", (unsigned long long)stats->histogram[b]);
+        }
+        NB_TELEMETRY_JSON_APPEND("]}");
+        first = false;
+    }
+    NB_TELEMETRY_JSON_APPEND("]}");
+
+    #undef NB_TELEMETRY_JSON_APPEND
+    return length;
+}
+
+#else
+
+#define NB_TELEMETRY_RECORD(telemetry, size, padding) ((void)0)
+
+#endif
@@ -1,11 +1,20 @@
 #ifndef COMMON_H
 #define COMMON_H
 
+// Must precede every system header, exposes O_DIRECT on Linux
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE
+#endif
+
 #include <stddef.h>
 #include <stdint.h>
 
 // ------------------- CONFIG --------------------
 #define NB_ASSERTIONS_ENABLED
+// Per arena/pool allocation stats by MemoryTag, compiled out when undefined
+// #define NB_TELEMETRY_ENABLED
+// Scoped zone profiler (NB_PROFILE_BEGIN/END), compiled out when undefined
+// #define NB_PROFILER_ENABLED
 
 //---------------------TYPES----------------------
 
@@ -85,6 +94,16 @@ typedef i32 b32;
 
 #define NB_DEFAULT_ALIGNMENT NB_ALIGNMENT
 
+// Separates data written by different threads to avoid false sharing
+#define NB_CACHE_LINE_SIZE 64
+
+// SIMD Detection
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define NB_SIMD_SSE2 1
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+#define NB_SIMD_NEON 1
+#endif
+
 // Compiler detection
 #if defined(_MSC_VER)
 #define NB_COMPILER_MSVC 1
@@ -117,6 +136,111 @@ typedef i32 b32;
 #define NB_FORCE_INLINE inline
 #endif
 
+// Thread Local
+#if defined(NB_COMPILER_MSVC)
+#define NB_THREAD_LOCAL __declspec(thread)
+#elif defined(NB_COMPILER_CLANG) || defined(NB_COMPILER_GCC)
+#define NB_THREAD_LOCAL __thread
+#else
+#define NB_THREAD_LOCAL _Thread_local
+#endif
+
+// Atomics
+// Loads acquire, stores release and read-modify-writes are sequentially consistent.
+#if defined(NB_COMPILER_MSVC)
+#include <intrin.h>
+
+#if defined(_M_ARM64)
+// The CPU reorders plain loads and stores, use the acquire/release instructions
+static NB_FORCE_INLINE u32 nb_atomic_load_u32(volatile u32* p) { return __ldar32((volatile unsigned __int32*)p); }
+static NB_FORCE_INLINE u64 nb_atomic_load_u64(volatile u64* p) { return __ldar64((volatile unsigned __int64*)p); }
+static NB_FORCE_INLINE void* nb_atomic_load_ptr(void* volatile* p) { return (void*)__ldar64((volatile unsigned __int64*)p); }
+static NB_FORCE_INLINE void nb_atomic_store_u32(volatile u32* p, u32 v) { __stlr32((volatile unsigned __int32*)p, v); }
+static NB_FORCE_INLINE void nb_atomic_store_u64(volatile u64* p, u64 v) { __stlr64((volatile unsigned __int64*)p, v); }
+static NB_FORCE_INLINE void nb_atomic_store_ptr(void* volatile* p, void* v) { __stlr64((volatile unsigned __int64*)p, (unsigned __int64)v); }
+#else
+// x64 loads and stores already have acquire/release ordering, only the compiler needs a barrier
+static NB_FORCE_INLINE u32 nb_atomic_load_u32(volatile u32* p) { u32 v = *p; _ReadWriteBarrier(); return v; }
+static NB_FORCE_INLINE u64 nb_atomic_load_u64(volatile u64* p) { u64 v = *p; _ReadWriteBarrier(); return v; }
+static NB_FORCE_INLINE void* nb_atomic_load_ptr(void* volatile* p) { void* v = *p; _ReadWriteBarrier(); return v; }
+static NB_FORCE_INLINE void nb_atomic_store_u32(volatile u32* p, u32 v) { _ReadWriteBarrier(); *p = v; }
+static NB_FORCE_INLINE void nb_atomic_store_u64(volatile u64* p, u64 v) { _ReadWriteBarrier(); *p = v; }
+static NB_FORCE_INLINE void nb_atomic_store_ptr(void* volatile* p, void* v) { _ReadWriteBarrier(); *p = v; }
+#endif
+static NB_FORCE_INLINE u32 nb_atomic_add_u32(volatile u32* p, u32 v) { return (u32)_InterlockedExchangeAdd((volatile long*)p, (long)v); }
+static NB_FORCE_INLINE u64 nb_atomic_add_u64(volatile u64* p, u64 v) { return (u64)_InterlockedExchangeAdd64((volatile __int64*)p, (__int64)v); }
+static NB_FORCE_INLINE u32 nb_atomic_exchange_u32(volatile u32* p, u32 v) { return (u32)_InterlockedExchange((volatile long*)p, (long)v); }
+static NB_FORCE_INLINE b32 nb_atomic_cas_u32(volatile u32* p, u32 expected, u32 desired) {
+    return (u32)_InterlockedCompareExchange((volatile long*)p, (long)desired, (long)expected) == expected;
+}
+static NB_FORCE_INLINE b32 nb_atomic_cas_u64(volatile u64* p, u64 expected, u64 desired) {
+    return (u64)_InterlockedCompareExchange64((volatile __int64*)p, (__int64)desired, (__int64)expected) == expected;
+}
+static NB_FORCE_INLINE b32 nb_atomic_cas_ptr(void* volatile* p, void* expected, void* desired) {
+    return _InterlockedCompareExchangePointer(p, desired, expected) == expected;
+}
+
+#if defined(_M_ARM64)
+static NB_FORCE_INLINE void nb_atomic_fence(void) { __dmb(_ARM64_BARRIER_ISH); }
+#else
+static NB_FORCE_INLINE void nb_atomic_fence(void) { _mm_mfence(); }
+#endif
+
+#if defined(_M_ARM64)
+#define NB_CPU_PAUSE() __yield()
+#else
+#define NB_CPU_PAUSE() _mm_pause()
+#endif
+
+#else
+
+#define NB_ATOMIC_ACQ __ATOMIC_ACQUIRE
+#define NB_ATOMIC_REL __ATOMIC_RELEASE
+#define NB_ATOMIC_SEQ __ATOMIC_SEQ_CST
+
+static NB_FORCE_INLINE u32 nb_atomic_load_u32(volatile u32* p) { return __atomic_load_n(p, NB_ATOMIC_ACQ); }
+static NB_FORCE_INLINE u64 nb_atomic_load_u64(volatile u64* p) { return __atomic_load_n(p, NB_ATOMIC_ACQ); }
+static NB_FORCE_INLINE void* nb_atomic_load_ptr(void* volatile* p) { return __atomic_load_n(p, NB_ATOMIC_ACQ); }
+static NB_FORCE_INLINE void nb_atomic_store_u32(volatile u32* p, u32 v) { __atomic_store_n(p, v, NB_ATOMIC_REL); }
+static NB_FORCE_INLINE void nb_atomic_store_u64(volatile u64* p, u64 v) { __atomic_store_n(p, v, NB_ATOMIC_REL); }
+static NB_FORCE_INLINE void nb_atomic_store_ptr(void* volatile* p, void* v) { __atomic_store_n(p, v, NB_ATOMIC_REL); }
+static NB_FORCE_INLINE u32 nb_atomic_add_u32(volatile u32* p, u32 v) { return __atomic_fetch_add(p, v, NB_ATOMIC_SEQ); }
+static NB_FORCE_INLINE u64 nb_atomic_add_u64(volatile u64* p, u64 v) { return __atomic_fetch_add(p, v, NB_ATOMIC_SEQ); }
+static NB_FORCE_INLINE u32 nb_atomic_exchange_u32(volatile u32* p, u32 v) { return __atomic_exchange_n(p, v, NB_ATOMIC_SEQ); }
+static NB_FORCE_INLINE b32 nb_atomic_cas_u32(volatile u32* p, u32 expected, u32 desired) {
+    return __atomic_compare_exchange_n(p, &expected, desired, false, NB_ATOMIC_SEQ, NB_ATOMIC_SEQ);
+}
+static NB_FORCE_INLINE b32 nb_atomic_cas_u64(volatile u64* p, u64 expected, u64 desired) {
+    return __atomic_compare_exchange_n(p, &expected, desired, false, NB_ATOMIC_SEQ, NB_ATOMIC_SEQ);
+}
+static NB_FORCE_INLINE b32 nb_atomic_cas_ptr(void* volatile* p, void* expected, void* desired) {
+    return __atomic_compare_exchange_n(p, &expected, desired, false, NB_ATOMIC_SEQ, NB_ATOMIC_SEQ);
+}
+
+static NB_FORCE_INLINE void nb_atomic_fence(void) { __atomic_thread_fence(NB_ATOMIC_SEQ); }
+
+#if defined(__x86_64__) || defined(__i386__)
+#define NB_CPU_PAUSE() __builtin_ia32_pause()
+#elif defined(__aarch64__)
+#define NB_CPU_PAUSE() __asm__ __volatile__("yield")
+#else
+#define NB_CPU_PAUSE() ((void)0)
+#endif
+
+#endif
+
+// Spin Lock
+static NB_FORCE_INLINE void nb_spin_lock(volatile u32* lock) {
+    while (nb_atomic_exchange_u32(lock, 1) != 0) {
+        while (nb_atomic_load_u32(lock) != 0) {
+            NB_CPU_PAUSE();
+        }
+    }
+}
+static NB_FORCE_INLINE void nb_spin_unlock(volatile u32* lock) {
+    nb_atomic_store_u32(lock, 0);
+}
+
 // Build configuration
 #ifdef NDEBUG
 #define NB_BUILD_RELEASE 1
@@ -173,4 +297,22 @@ typedef i32 b32;
 #define NB_MAX(a, b) ((a) > (b) ? (a) : (b))
 #define NB_EPSILON_F 1e-6 
 
+// Read prefetch into all cache levels, only a hint
+#if defined(NB_COMPILER_MSVC) && defined(NB_ARCH_ARM64)
+#define NB_PREFETCH(ptr) __prefetch((const void*)(ptr))
+#elif defined(NB_COMPILER_MSVC)
+#define NB_PREFETCH(ptr) _mm_prefetch((const char*)(ptr), _MM_HINT_T0)
+#else
+#define NB_PREFETCH(ptr) __builtin_prefetch((ptr), 0, 3)
+#endif
+
+// Bit scans, undefined for 0
+#if defined(NB_COMPILER_MSVC)
+static NB_FORCE_INLINE u32 nb_count_leading_zeros64(u64 x) { unsigned long i; _BitScanReverse64(&i, x); return 63 - (u32)i; }
+static NB_FORCE_INLINE u32 nb_count_trailing_zeros64(u64 x) { unsigned long i; _BitScanForward64(&i, x); return (u32)i; }
+#else
+static NB_FORCE_INLINE u32 nb_count_leading_zeros64(u64 x) { return (u32)__builtin_clzll(x); }
+static NB_FORCE_INLINE u32 nb_count_trailing_zeros64(u64 x) { return (u32)__builtin_ctzll(x); }
+#endif
+
 #endif // COMMON_H
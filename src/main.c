@@ -1,28 +1,151 @@
 #include "platform/platform.c"
 #include "base/base.c"
 
+#ifdef NB_HASH_BENCH
+// Compares wyhash against the byte-at-a-time FNV-1a the hashtable used to
+// use, on asset path style keys. Build with `just bench`.
+internal u64 bench_hash_fnv1a(const char* key, usize length) {
+    u64 hash = 14695981039346656037ULL;
+    for (usize i = 0; i < length; i++) {
+        hash ^= (u8)key[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+internal void bench_hash(void) {
+    const u32 key_count = 1 << 16;
+    const u32 rounds = 32;
+    const u32 bucket_mask = key_count - 1;
+    const char* folders[] = { "textures", "meshes", "materials", "shaders", "scenes/interior" };
+    const char* suffixes[] = { "_albedo.png", "_normal.png", "_roughness.png", ".gltf", ".mat" };
+
+    Arena* arena = nb_arena_create_growable((usize)64 * 1024 * 1024, 0);
+    char** keys = nb_arena_alloc(arena, sizeof(char*) * key_count);
+    usize* lengths = nb_arena_alloc(arena, sizeof(usize) * key_count);
+    u32* buckets = nb_arena_alloc(arena, sizeof(u32) * key_count);
+    usize total_length = 0;
+    for (u32 i = 0; i < key_count; i++) {
+        char buffer[256];
+        int length = snprintf(buffer, sizeof(buffer), "assets/%s/level_%02u/prop_%05u%s",
+            folders[i % 5], (i / 7) % 40, i, suffixes[(i / 5) % 5]);
+        keys[i] = nb_arena_alloc(arena, (usize)length + 1);
+        memcpy(keys[i], buffer, (usize)length + 1);
+        lengths[i] = (usize)length;
+        total_length += (usize)length;
+    }
+
+    for (u32 pass = 0; pass < 2; pass++) {
+        const char* name = pass == 0 ? "fnv1a " : "wyhash";
+        u64 sink = 0;
+        u64 start = platform_time_get_cycles();
+        for (u32 r = 0; r < rounds; r++) {
+            for (u32 i = 0; i < key_count; i++) {
+                sink += pass == 0 ? bench_hash_fnv1a(keys[i], lengths[i]) : nb_hash_bytes(keys[i], lengths[i], 0);
+            }
+        }
+        u64 ns = platform_time_cycles_to_nanoseconds(platform_time_get_cycles() - start);
+
+        // Quality of the low bits the hashtable masks with, an ideal hash
+        // leaves ~36.8% of the buckets empty
+        memset(buckets, 0, sizeof(u32) * key_count);
+        u32 empty = 0, longest = 0;
+        for (u32 i = 0; i < key_count; i++) {
+            u64 hash = pass == 0 ? bench_hash_fnv1a(keys[i], lengths[i]) : nb_hash_bytes(keys[i], lengths[i], 0);
+            buckets[hash & bucket_mask]++;
+        }
+        for (u32 i = 0; i < key_count; i++) {
+            empty += buckets[i] == 0;
+            longest = NB_MAX(longest, buckets[i]);
+        }
+
+        f64 keys_hashed = (f64)key_count * rounds;
+        platform_debug_print("%s: %.2f ns/key, %.2f GB/s, %.1f%% buckets empty, longest chain %u (sink %llx)\n",
+            name, (f64)ns / keys_hashed, (f64)total_length * rounds / (f64)ns,
+            100.0 * empty / key_count, longest, (unsigned long long)(sink & 0xff));
+    }
+    platform_debug_print("average key length: %.1f bytes\n", (f64)total_length / key_count);
+    nb_arena_destroy(arena);
+}
+#endif
+
+#ifdef NB_NUMA_CHECK
+// Smoke check of the NUMA queries and node bound arenas, also meaningful on
+// a single node machine where binding falls back to a no-op. Build with
+// `just numa-check`.
+internal void numa_check(void) {
+    u32 node_count = platform_numa_node_count();
+    u32 current = platform_numa_current_node();
+    platform_debug_print("numa: %u node(s), running on node %u\n", node_count, current);
+    NB_ASSERT(node_count >= 1);
+    NB_ASSERT(current < node_count);
+
+    const usize size = (usize)4 * 1024 * 1024;
+    for (u32 node = 0; node < node_count; node++) {
+        b32 thread_bound = platform_numa_set_thread_node(node);
+        NB_ASSERT(thread_bound);
+        (void)thread_bound;
+
+        Arena* arena = nb_arena_create_on_node((usize)64 * 1024 * 1024, 0, node);
+        NB_ASSERT(arena != null);
+        u8* memory = nb_arena_alloc(arena, size);
+        NB_ASSERT(memory != null);
+        memset(memory, (int)node + 1, size);
+        NB_ASSERT(memory[0] == node + 1 && memory[size - 1] == node + 1);
+
+        // Binding an existing range is a no-op that succeeds on one node and
+        // unsupported on Win32, where pages follow the thread's node instead
+        void* range = platform_memory_reserve(size);
+        b32 range_bound = platform_memory_bind_node(range, size, node);
+#if defined(NB_PLATFORM_WINDOWS)
+        NB_ASSERT(range_bound || node_count > 1);
+#else
+        NB_ASSERT(range_bound);
+#endif
+        platform_memory_commit(range, size);
+        memset(range, 0, size);
+        platform_memory_release(range, size);
+
+        nb_arena_destroy(arena);
+        platform_debug_print("numa: node %u arena ok, range %s\n", node, range_bound ? "bound" : "first touch");
+    }
+    // Leave the thread preferring the node it started on
+    platform_numa_set_thread_node(current);
+}
+#endif
+
 // ENTRYPOINT --------------------------------------------
 
 int main(int argc, char** argv) {
     Arena* arena = nb_arena_create(null, 1024*1024);
-    platform_debug_print("Program arena peak usage: %d bytes\n", nb_arena_peak_memory(arena));
+    platform_debug_print("Program arena peak usage: %zu bytes\n", nb_arena_peak_memory(arena));
  
     Pool* p = nb_pool_create(arena, sizeof(u64), 1000);
 
     u64* n1 = nb_pool_alloc(p);
     u64* n2 = nb_pool_alloc(p);
     u64* n3 = nb_pool_alloc(p);
-    platform_debug_print("pool usage: %d bytes\n", nb_pool_used_memory(p));
+    platform_debug_print("pool usage: %zu bytes\n", nb_pool_used_memory(p));
     u64* n4 = nb_pool_alloc(p);
-    platform_debug_print("pool usage: %d bytes\n", nb_pool_used_memory(p));
+    platform_debug_print("pool usage: %zu bytes\n", nb_pool_used_memory(p));
     nb_pool_free(p, n1);
     nb_pool_free(p, n2);
-    platform_debug_print("pool usage: %d bytes\n", nb_pool_used_memory(p));
-    platform_debug_print("pool peak usage: %d bytes\n", nb_pool_peak_memory(p));
+    platform_debug_print("pool usage: %zu bytes\n", nb_pool_used_memory(p));
+    platform_debug_print("pool peak usage: %zu bytes\n", nb_pool_peak_memory(p));
 
 
 
-    platform_debug_print("Program arena peak usage: %d bytes\n", nb_arena_peak_memory(arena));
+    platform_debug_print("Program arena peak usage: %zu bytes\n", nb_arena_peak_memory(arena));
+#ifdef NB_HASH_BENCH
+    bench_hash();
+#endif
+#ifdef NB_NUMA_CHECK
+    numa_check();
+#endif
+#ifdef NB_TELEMETRY_ENABLED
+    nb_telemetry_report(nb_arena_telemetry(arena), "program arena");
+    nb_telemetry_report(nb_pool_telemetry(p), "u64 pool");
+#endif
     nb_arena_destroy(arena);
     arena = null;
 }
\ No newline at end of file
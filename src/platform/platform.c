@@ -1,4 +1,5 @@
 #include "platform.h"
+#include "platform_io_threaded.c"
 
 #if defined(NB_PLATFORM_WINDOWS)
     #include "platform_win32.c"
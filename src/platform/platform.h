@@ -12,22 +12,184 @@ typedef enum {
     PLATFORM_MEMORY_PROTECTION_EXEC    = 1 << 2,
 } PlatformMemoryProtection;
 
+typedef enum {
+    PLATFORM_MEMORY_FLAG_NONE           = 0,
+    // Ask for transparent huge pages on the range (Linux only)
+    PLATFORM_MEMORY_FLAG_HUGE_PAGES     = 1 << 0,
+    // Explicit large pages (MAP_HUGETLB / MEM_LARGE_PAGES), falls back to
+    // huge pages when the system has none available. Size is rounded up to
+    // platform_memory_get_large_page_size(). On Win32 the range is committed
+    // at reserve time and commit/decommit on it do nothing.
+    PLATFORM_MEMORY_FLAG_LARGE_PAGES    = 1 << 1,
+    // Fault the pages in at commit time instead of on first touch
+    PLATFORM_MEMORY_FLAG_PREFAULT       = 1 << 2,
+} PlatformMemoryFlags;
+
 void*   platform_memory_reserve(usize size);
+void*   platform_memory_reserve_ex(usize size, u32 flags);
 void    platform_memory_commit(void* ptr, usize size);
+void    platform_memory_commit_ex(void* ptr, usize size, u32 flags);
 void    platform_memory_decommit(void* ptr, usize size);
 void    platform_memory_release(void* ptr, usize size);
 void    platform_memory_set_protection(void* ptr, usize size, u32 flags);
 usize   platform_memory_get_page_size(void);
+usize   platform_memory_get_large_page_size(void);
+
+// NUMA ----------------------------------------------------------
+
+u32     platform_numa_node_count(void);
+u32     platform_numa_current_node(void);
+// Prefer 'node' for pages of the range that aren't faulted in yet. Call it
+// between reserve and commit. No-op returning true on single node machines.
+// Returns false on multi node Win32, which can't bind an existing range,
+// pages there follow platform_numa_set_thread_node instead.
+b32     platform_memory_bind_node(void* ptr, usize size, u32 node);
+// Prefer 'node' for memory the calling thread faults in from now on
+b32     platform_numa_set_thread_node(u32 node);
+
+// THREADS -------------------------------------------------------
+
+typedef void (*PlatformThreadProc)(void* data);
+
+// Owned by the caller, must stay alive until platform_thread_join
+typedef struct PlatformThread {
+    u64 handle;
+    PlatformThreadProc proc;
+    void* data;
+} PlatformThread;
+
+b32     platform_thread_create(PlatformThread* thread, PlatformThreadProc proc, void* data);
+void    platform_thread_join(PlatformThread* thread);
+// A thread's CPU affinity, saved to be restored after pinning
+typedef struct PlatformAffinity {
+    u64 data[64];   // Fits a 4096 CPU Linux mask
+} PlatformAffinity;
+
+// Pins the calling thread to the cpu-th logical CPU the process may run on,
+// cpu goes from 0 to platform_cpu_count() - 1. Under taskset or a cpuset
+// cgroup that skips the CPUs outside the allowed set.
+b32     platform_thread_set_affinity(u32 cpu);
+b32     platform_thread_save_affinity(PlatformAffinity* affinity);
+b32     platform_thread_restore_affinity(const PlatformAffinity* affinity);
+u32     platform_thread_get_id(void);
+void    platform_thread_yield(void);
+// Logical CPUs the process is allowed to run on, read once on first use of
+// this or platform_thread_set_affinity
+u32     platform_cpu_count(void);
+
+// Blocks while *address == expected, can wake up spuriously
+void    platform_futex_wait(volatile u32* address, u32 expected);
+void    platform_futex_wake_one(volatile u32* address);
+void    platform_futex_wake_all(volatile u32* address);
 
 // FILE IO -------------------------------------------------------
 
 typedef struct PlatformFile PlatformFile;
 
+typedef enum {
+    PLATFORM_FILE_OPEN_READ         = 1 << 0,
+    // Creates the file if it doesn't exist
+    PLATFORM_FILE_OPEN_WRITE        = 1 << 1,
+    // Implies WRITE
+    PLATFORM_FILE_OPEN_TRUNCATE     = 1 << 2,
+    // Every write goes to the end of the file
+    PLATFORM_FILE_OPEN_APPEND       = 1 << 3,
+    // Bypasses the page cache. Buffers, sizes and offsets then have to be
+    // multiples of the page size.
+    PLATFORM_FILE_OPEN_DIRECT       = 1 << 4,
+} PlatformFileOpenFlags;
+
+typedef enum {
+    PLATFORM_FILE_ACCESS_NORMAL,
+    PLATFORM_FILE_ACCESS_SEQUENTIAL,
+    PLATFORM_FILE_ACCESS_RANDOM,
+    // Start reading the range in now
+    PLATFORM_FILE_ACCESS_WILL_NEED,
+    // Drop the range from the page cache
+    PLATFORM_FILE_ACCESS_DONT_NEED,
+} PlatformFileAccess;
+
+// Opens for reading and writing, creating the file if needed
 PlatformFile*   platform_file_open(const char* filepath);
+PlatformFile*   platform_file_open_ex(const char* filepath, u32 flags);
+// Reads and writes loop until 'size' bytes are done, they return less only
+// at the end of the file or on an error
 usize           platform_file_read(PlatformFile* f, void* buffer, usize size);
 usize           platform_file_write(PlatformFile* f, void* buffer, usize size);
+// Positional versions, leave the file position alone and are safe to call
+// from several threads on the same file
+usize           platform_file_read_at(PlatformFile* f, void* buffer, usize size, u64 offset);
+usize           platform_file_write_at(PlatformFile* f, void* buffer, usize size, u64 offset);
+// Access pattern hint for [offset, offset + size), a size of 0 means to the
+// end of the file. Only a hint, a no-op where unsupported (Win32).
+b32             platform_file_advise(PlatformFile* f, u64 offset, u64 size, u32 access);
 b32             platform_file_close(PlatformFile* f);
 b32             platform_file_exists(const char* filepath);
+u64             platform_file_size(PlatformFile* f);
+
+typedef enum {
+    PLATFORM_FILE_MAP_READ              = 0,
+    // Writable view, writes stay private to the process and never reach the file
+    PLATFORM_FILE_MAP_COPY_ON_WRITE     = 1 << 0,
+    // Hint the view is read front to back so read ahead can be more aggressive (Linux only)
+    PLATFORM_FILE_MAP_SEQUENTIAL        = 1 << 1,
+    // Start reading the whole file in now instead of on first touch
+    PLATFORM_FILE_MAP_WILL_NEED         = 1 << 2,
+} PlatformFileMapFlags;
+
+typedef struct PlatformFileMapping {
+    void* data;
+    usize size;
+} PlatformFileMapping;
+
+// Maps the whole file, the view stays valid after the file is closed. An
+// empty file maps to a null view of size 0.
+b32             platform_file_map(PlatformFile* f, u32 flags, PlatformFileMapping* mapping);
+void            platform_file_unmap(PlatformFileMapping* mapping);
+
+// ASYNC IO ------------------------------------------------------
+
+// Positional reads and writes that complete in the background. Linux uses
+// io_uring and falls back to a small thread pool where the kernel doesn't
+// have it, Win32 always uses the thread pool. A queue belongs to the thread
+// that created it, buffers must stay alive until their completion is polled.
+typedef struct PlatformIoQueue PlatformIoQueue;
+
+typedef enum {
+    PLATFORM_IO_OP_READ,
+    PLATFORM_IO_OP_WRITE,
+} PlatformIoOp;
+
+typedef enum {
+    PLATFORM_IO_QUEUE_FLAG_NONE     = 0,
+    // Use the thread pool even where io_uring is available
+    PLATFORM_IO_QUEUE_FLAG_THREADED = 1 << 0,
+} PlatformIoQueueFlags;
+
+typedef struct PlatformIoRequest {
+    PlatformFile* file;
+    void* buffer;
+    u64 offset;
+    u32 size;
+    u32 op;             // PlatformIoOp
+    void* user_data;    // Handed back in the completion
+} PlatformIoRequest;
+
+typedef struct PlatformIoCompletion {
+    void* user_data;
+    i64 result;         // Bytes transferred, negative on error
+} PlatformIoCompletion;
+
+// 'depth' is the most requests in flight at once, rounded up to a power of two
+PlatformIoQueue*    platform_io_queue_create(u32 depth, u32 flags);
+// Waits for the requests the kernel took, drops the ones it never did
+void                platform_io_queue_destroy(PlatformIoQueue* queue);
+// Queues as many of the requests as there is room for and returns that count
+u32                 platform_io_submit(PlatformIoQueue* queue, PlatformIoRequest* requests, u32 count);
+// Copies out up to 'max' completions, with 'wait' blocks until there is at least one.
+// Returns 0 even with 'wait' if the kernel won't take or complete the queued requests.
+u32                 platform_io_poll(PlatformIoQueue* queue, PlatformIoCompletion* completions, u32 max, b32 wait);
+u32                 platform_io_in_flight(PlatformIoQueue* queue);
 
 // TIMING --------------------------------------------------------
 
@@ -35,6 +197,17 @@ u64     platform_time_get_ticks(void);
 f64     platform_time_get_seconds(void);
 void    platform_time_sleep(u32 ms);
 
+// Raw CPU counter (rdtsc / cntvct_el0), a few cycles to read instead of a
+// clock call. Meant for timing short spans on one thread, it needs an
+// invariant TSC on x64 which every CPU of the last decade has. Falls back
+// to the monotonic clock on other architectures.
+u64     platform_time_get_cycles(void);
+// Counter increments per second, calibrated against the monotonic clock on
+// first use (~10ms) unless the CPU reports it
+u64     platform_time_get_cycle_frequency(void);
+f64     platform_time_cycles_to_seconds(u64 cycles);
+u64     platform_time_cycles_to_nanoseconds(u64 cycles);
+
 // DEBUG ------------------------------------------------
 
 void platform_debug_print(const char* fmt, ...);
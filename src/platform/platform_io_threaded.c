@@ -0,0 +1,147 @@
+#include "platform.h"
+
+// Thread pool backing PlatformIoQueue where the OS has no usable async API.
+// Requests go through a ring to the workers, which run them as blocking
+// positional calls and put the results on a completion ring. Both rings
+// hold 'depth' entries and at most 'depth' requests are in flight, so
+// neither can overflow.
+
+#define THREADED_IO_MAX_THREADS 4
+
+// Runs one request synchronously, implemented by each OS file
+internal i64 platform_io_execute(PlatformIoRequest* request);
+
+typedef struct ThreadedIoQueue {
+    PlatformIoRequest* requests;
+    PlatformIoCompletion* completions;
+    u32 mask;
+    u32 request_head;
+    u32 request_tail;
+    u32 completion_head;
+    u32 completion_tail;
+    u32 in_flight;
+    b32 stopping;
+    volatile u32 lock;
+    // Futex words, bumped whenever a request or a completion is added
+    volatile u32 request_signal;
+    volatile u32 completion_signal;
+
+    u32 thread_count;
+    PlatformThread threads[THREADED_IO_MAX_THREADS];
+    usize reserve_size;
+} ThreadedIoQueue;
+
+internal void threaded_io_worker(void* data) {
+    ThreadedIoQueue* queue = data;
+    for (;;) {
+        nb_spin_lock(&queue->lock);
+        if (queue->request_head == queue->request_tail) {
+            if (queue->stopping) {
+                nb_spin_unlock(&queue->lock);
+                return;
+            }
+            u32 signal = queue->request_signal;
+            nb_spin_unlock(&queue->lock);
+            platform_futex_wait(&queue->request_signal, signal);
+            continue;
+        }
+        PlatformIoRequest request = queue->requests[queue->request_head++ & queue->mask];
+        nb_spin_unlock(&queue->lock);
+
+        i64 result = platform_io_execute(&request);
+
+        nb_spin_lock(&queue->lock);
+        PlatformIoCompletion* completion = &queue->completions[queue->completion_tail++ & queue->mask];
+        completion->user_data = request.user_data;
+        completion->result = result;
+        queue->completion_signal++;
+        nb_spin_unlock(&queue->lock);
+        platform_futex_wake_one(&queue->completion_signal);
+    }
+}
+
+internal ThreadedIoQueue* threaded_io_create(u32 depth) {
+    usize size = sizeof(ThreadedIoQueue) + 
+        depth * (sizeof(PlatformIoRequest) + sizeof(PlatformIoCompletion));
+    ThreadedIoQueue* queue = platform_memory_reserve(size);
+    if (queue == null) {
+        return null;
+    }
+    platform_memory_commit(queue, size);
+
+    queue->requests = (PlatformIoRequest*)(queue + 1);
+    queue->completions = (PlatformIoCompletion*)(queue->requests + depth);
+    queue->mask = depth - 1;
+    queue->reserve_size = size;
+
+    queue->thread_count = NB_MIN(NB_MIN(depth, platform_cpu_count()), THREADED_IO_MAX_THREADS);
+    queue->thread_count = NB_MAX(queue->thread_count, 1);
+    for (u32 i = 0; i < queue->thread_count; i++) {
+        if (!platform_thread_create(&queue->threads[i], threaded_io_worker, queue)) {
+            queue->thread_count = i;
+            break;
+        }
+    }
+    if (queue->thread_count == 0) {
+        platform_memory_release(queue, size);
+        return null;
+    }
+    return queue;
+}
+
+internal void threaded_io_destroy(ThreadedIoQueue* queue) {
+    // Workers drain the requests left before they see 'stopping'
+    nb_spin_lock(&queue->lock);
+    queue->stopping = true;
+    queue->request_signal++;
+    nb_spin_unlock(&queue->lock);
+    platform_futex_wake_all(&queue->request_signal);
+    for (u32 i = 0; i < queue->thread_count; i++) {
+        platform_thread_join(&queue->threads[i]);
+    }
+    platform_memory_release(queue, queue->reserve_size);
+}
+
+internal u32 threaded_io_submit(ThreadedIoQueue* queue, PlatformIoRequest* requests, u32 count) {
+    nb_spin_lock(&queue->lock);
+    count = NB_MIN(count, queue->mask + 1 - queue->in_flight);
+    for (u32 i = 0; i < count; i++) {
+        queue->requests[queue->request_tail++ & queue->mask] = requests[i];
+    }
+    queue->in_flight += count;
+    queue->request_signal++;
+    nb_spin_unlock(&queue->lock);
+
+    if (count > 1) {
+        platform_futex_wake_all(&queue->request_signal);
+    } else if (count == 1) {
+        platform_futex_wake_one(&queue->request_signal);
+    }
+    return count;
+}
+
+internal u32 threaded_io_poll(ThreadedIoQueue* queue, PlatformIoCompletion* completions, u32 max, b32 wait) {
+    for (;;) {
+        nb_spin_lock(&queue->lock);
+        u32 count = 0;
+        while (count < max && queue->completion_head != queue->completion_tail) {
+            completions[count++] = queue->completions[queue->completion_head++ & queue->mask];
+        }
+        queue->in_flight -= count;
+        u32 signal = queue->completion_signal;
+        b32 idle = queue->in_flight == 0;
+        nb_spin_unlock(&queue->lock);
+
+        if (count > 0 || !wait || idle || max == 0) {
+            return count;
+        }
+        platform_futex_wait(&queue->completion_signal, signal);
+    }
+}
+
+internal u32 threaded_io_in_flight(ThreadedIoQueue* queue) {
+    nb_spin_lock(&queue->lock);
+    u32 in_flight = queue->in_flight;
+    nb_spin_unlock(&queue->lock);
+    return in_flight;
+}
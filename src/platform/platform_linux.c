@@ -4,11 +4,40 @@
 #include <stdarg.h>
 #include <fcntl.h>
 #include <time.h>
+#include <string.h>
+#include <sys/syscall.h>
+#include <sys/stat.h>
+#include <pthread.h>
+#include <sched.h>
+#include <linux/futex.h>
+#include <linux/io_uring.h>
+#include <errno.h>
+
+// common.h defines _GNU_SOURCE, it's missing when a system header got included first
+#ifndef O_DIRECT
+#error "O_DIRECT needs _GNU_SOURCE, include common.h before any system header"
+#endif
 
 // GLOBALS --------------------------------------------------
 
-global struct timespec linux_time_start;
+global u64 linux_time_start;
 global b32 linux_time_initialized = false;
+global volatile u64 linux_time_cycle_frequency = 0;
+
+global usize linux_memory_large_page_size = 0;
+
+global u32   linux_numa_node_count = 0;
+
+// Covers the kernel's default NR_CPUS
+#define LINUX_MAX_CPUS 4096
+#define LINUX_CPU_MASK_WORDS (LINUX_MAX_CPUS / (8 * sizeof(unsigned long)))
+
+global unsigned long linux_cpu_allowed[LINUX_CPU_MASK_WORDS];
+global u32           linux_cpu_allowed_count = 0;
+global volatile u32  linux_cpu_state = 0; // 0 unread, 1 reading, 2 ready
+
+global PlatformFile* linux_file_free_list = null;
+global volatile u32 linux_file_lock = 0;
 
 // MEMORY ---------------------------------------------------
 
@@ -27,14 +56,83 @@ void* platform_memory_reserve(usize size) {
     return ptr;
 }
 
+// Reserves 'size' bytes aligned to 'align' by over-reserving and trimming
+internal void* linux_memory_reserve_aligned(usize size, usize align) {
+    usize padded_size = size + align;
+    u8* ptr = mmap(null, padded_size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (ptr == MAP_FAILED) {
+        return null;
+    }
+
+    u8* aligned = (u8*)(((uptr)ptr + align - 1) & ~(uptr)(align - 1));
+    usize head = aligned - ptr;
+    usize tail = padded_size - head - size;
+    if (head) {
+        munmap(ptr, head);
+    }
+    if (tail) {
+        munmap(aligned + size, tail);
+    }
+    return aligned;
+}
+
+void* platform_memory_reserve_ex(usize size, u32 flags) {
+    if (!(flags & (PLATFORM_MEMORY_FLAG_HUGE_PAGES | PLATFORM_MEMORY_FLAG_LARGE_PAGES))) {
+        return platform_memory_reserve(size);
+    }
+
+    usize large_page_size = platform_memory_get_large_page_size();
+    usize actual_size = (size + large_page_size - 1) & ~(large_page_size - 1);
+
+    if (flags & PLATFORM_MEMORY_FLAG_LARGE_PAGES) {
+        // The whole range is taken from /proc/sys/vm/nr_hugepages up front so the
+        // mmap fails (rather than SIGBUS on touch) when there aren't enough,
+        // fall back to THP in that case
+        void* ptr = mmap(null, actual_size, PROT_NONE, 
+            MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (ptr != MAP_FAILED) {
+            return ptr;
+        }
+    }
+
+    void* ptr = linux_memory_reserve_aligned(actual_size, large_page_size);
+    if (ptr) {
+        madvise(ptr, actual_size, MADV_HUGEPAGE);
+    }
+    return ptr;
+}
+
 void platform_memory_commit(void* ptr, usize size) {
     usize actual_size = linux_memory_round_up_to_page_size(size);
     int status = mprotect(ptr, actual_size, PROT_READ | PROT_WRITE);
     NB_ASSERT_MSG(status == 0, "Failed to commit memory");
 }
+
+#ifndef MADV_POPULATE_WRITE
+#define MADV_POPULATE_WRITE 23
+#endif
+
+void platform_memory_commit_ex(void* ptr, usize size, u32 flags) {
+    platform_memory_commit(ptr, size);
+
+    if (flags & PLATFORM_MEMORY_FLAG_PREFAULT) {
+        usize actual_size = linux_memory_round_up_to_page_size(size);
+        // MADV_POPULATE_WRITE needs Linux 5.14, touch the pages ourselves before that
+        if (madvise(ptr, actual_size, MADV_POPULATE_WRITE) != 0) {
+            usize page_size = platform_memory_get_page_size();
+            for (usize offset = 0; offset < actual_size; offset += page_size) {
+                volatile u8* page = (volatile u8*)ptr + offset;
+                *page = *page;
+            }
+        }
+    }
+}
 void platform_memory_decommit(void* ptr, usize size) {
     usize actual_size = linux_memory_round_up_to_page_size(size);
     madvise(ptr, actual_size, MADV_DONTNEED);
+    // MADV_DONTNEED leaves the pages readable as zeros, make them trap like
+    // decommitted pages on Win32 until they are committed again
+    mprotect(ptr, actual_size, PROT_NONE);
 }
 void platform_memory_release(void* ptr, usize size) {
     usize actual_size = linux_memory_round_up_to_page_size(size);
@@ -51,43 +149,387 @@ usize platform_memory_get_page_size(void) {
     return sysconf(_SC_PAGESIZE);
 }
 
+usize platform_memory_get_large_page_size(void) {
+    if (linux_memory_large_page_size != 0) {
+        return linux_memory_large_page_size;
+    }
+
+    usize size = 2 * 1024 * 1024;
+    int fd = open("/proc/meminfo", O_RDONLY);
+    if (fd != -1) {
+        char buffer[4096];
+        ssize_t length = read(fd, buffer, sizeof(buffer) - 1);
+        close(fd);
+        if (length > 0) {
+            buffer[length] = 0;
+            const char* line = strstr(buffer, "Hugepagesize:");
+            if (line) {
+                usize kb = 0;
+                for (const char* p = line + 13; *p && *p != '\n'; p++) {
+                    if (*p >= '0' && *p <= '9') {
+                        kb = kb * 10 + (usize)(*p - '0');
+                    }
+                }
+                if (kb != 0) {
+                    size = kb * 1024;
+                }
+            }
+        }
+    }
+
+    linux_memory_large_page_size = size;
+    return size;
+}
+
+// NUMA ----------------------------------------------------------
+
+#define LINUX_MPOL_PREFERRED 1
+#define LINUX_NUMA_MAX_NODES 1024
+
+u32 platform_numa_node_count(void) {
+    if (linux_numa_node_count != 0) {
+        return linux_numa_node_count;
+    }
+
+    // "0" on single node machines, "0-1" or "0,2-3" otherwise
+    u32 count = 1;
+    int fd = open("/sys/devices/system/node/possible", O_RDONLY);
+    if (fd != -1) {
+        char buffer[256];
+        ssize_t length = read(fd, buffer, sizeof(buffer) - 1);
+        close(fd);
+        if (length > 0) {
+            u32 value = 0;
+            u32 highest = 0;
+            for (ssize_t i = 0; i < length; i++) {
+                if (buffer[i] >= '0' && buffer[i] <= '9') {
+                    value = value * 10 + (u32)(buffer[i] - '0');
+                    highest = NB_MAX(highest, value);
+                } else {
+                    value = 0;
+                }
+            }
+            count = NB_MIN(highest + 1, LINUX_NUMA_MAX_NODES);
+        }
+    }
+
+    linux_numa_node_count = count;
+    return count;
+}
+
+u32 platform_numa_current_node(void) {
+    unsigned int cpu = 0;
+    unsigned int node = 0;
+    if (syscall(SYS_getcpu, &cpu, &node, null) != 0) {
+        return 0;
+    }
+    return node;
+}
+
+b32 platform_memory_bind_node(void* ptr, usize size, u32 node) {
+    if (platform_numa_node_count() <= 1) {
+        return true;
+    }
+    if (node >= platform_numa_node_count()) {
+        return false;
+    }
+
+    unsigned long mask[LINUX_NUMA_MAX_NODES / (8 * sizeof(unsigned long))] = {0};
+    mask[node / (8 * sizeof(unsigned long))] = 1UL << (node % (8 * sizeof(unsigned long)));
+
+    usize actual_size = linux_memory_round_up_to_page_size(size);
+    long status = syscall(SYS_mbind, ptr, actual_size, LINUX_MPOL_PREFERRED, 
+        mask, LINUX_NUMA_MAX_NODES, 0);
+    return status == 0;
+}
+
+b32 platform_numa_set_thread_node(u32 node) {
+    if (platform_numa_node_count() <= 1) {
+        return true;
+    }
+    if (node >= platform_numa_node_count()) {
+        return false;
+    }
+
+    unsigned long mask[LINUX_NUMA_MAX_NODES / (8 * sizeof(unsigned long))] = {0};
+    mask[node / (8 * sizeof(unsigned long))] = 1UL << (node % (8 * sizeof(unsigned long)));
+
+    long status = syscall(SYS_set_mempolicy, LINUX_MPOL_PREFERRED, mask, LINUX_NUMA_MAX_NODES);
+    return status == 0;
+}
+
+// THREADS ------------------------------------------------------
+
+internal void* linux_thread_proc(void* data) {
+    PlatformThread* thread = data;
+    thread->proc(thread->data);
+    return null;
+}
+
+b32 platform_thread_create(PlatformThread* thread, PlatformThreadProc proc, void* data) {
+    thread->proc = proc;
+    thread->data = data;
+    pthread_t handle;
+    if (pthread_create(&handle, null, linux_thread_proc, thread) != 0) {
+        return false;
+    }
+    thread->handle = (u64)handle;
+    return true;
+}
+
+void platform_thread_join(PlatformThread* thread) {
+    pthread_join((pthread_t)thread->handle, null);
+}
+
+// The affinity mask respects taskset and cgroup cpusets, unlike sysconf.
+// It's read once so threads that pinned themselves still see the full set.
+internal void linux_cpu_init(void) {
+    if (nb_atomic_load_u32(&linux_cpu_state) == 2) {
+        return;
+    }
+    if (!nb_atomic_cas_u32(&linux_cpu_state, 0, 1)) {
+        while (nb_atomic_load_u32(&linux_cpu_state) != 2) {
+            NB_CPU_PAUSE();
+        }
+        return;
+    }
+
+    long bytes = syscall(SYS_sched_getaffinity, 0, sizeof(linux_cpu_allowed), linux_cpu_allowed);
+    u32 count = 0;
+    if (bytes > 0) {
+        for (usize i = 0; i < (usize)bytes / sizeof(unsigned long); i++) {
+            count += (u32)__builtin_popcountl(linux_cpu_allowed[i]);
+        }
+    }
+    if (count == 0) {
+        // No mask, assume CPUs 0..n-1 are online
+        long online = sysconf(_SC_NPROCESSORS_ONLN);
+        count = (u32)NB_MIN(NB_MAX(online, 1), LINUX_MAX_CPUS);
+        memset(linux_cpu_allowed, 0, sizeof(linux_cpu_allowed));
+        for (u32 i = 0; i < count; i++) {
+            linux_cpu_allowed[i / (8 * sizeof(unsigned long))] |= 1UL << (i % (8 * sizeof(unsigned long)));
+        }
+    }
+    linux_cpu_allowed_count = count;
+    nb_atomic_store_u32(&linux_cpu_state, 2);
+}
+
+b32 platform_thread_set_affinity(u32 cpu) {
+    linux_cpu_init();
+    if (cpu >= linux_cpu_allowed_count) {
+        return false;
+    }
+
+    // Find the cpu-th set bit of the allowed mask
+    for (usize word = 0; word < LINUX_CPU_MASK_WORDS; word++) {
+        u32 bits = (u32)__builtin_popcountl(linux_cpu_allowed[word]);
+        if (cpu >= bits) {
+            cpu -= bits;
+            continue;
+        }
+        unsigned long remaining = linux_cpu_allowed[word];
+        for (u32 i = 0; i < cpu; i++) {
+            remaining &= remaining - 1;
+        }
+        unsigned long mask[LINUX_CPU_MASK_WORDS] = {0};
+        mask[word] = remaining & (~remaining + 1);
+        return syscall(SYS_sched_setaffinity, 0, sizeof(mask), mask) == 0;
+    }
+    return false;
+}
+
+b32 platform_thread_save_affinity(PlatformAffinity* affinity) {
+    memset(affinity, 0, sizeof(PlatformAffinity));
+    return syscall(SYS_sched_getaffinity, 0, sizeof(affinity->data), affinity->data) > 0;
+}
+
+b32 platform_thread_restore_affinity(const PlatformAffinity* affinity) {
+    return syscall(SYS_sched_setaffinity, 0, sizeof(affinity->data), affinity->data) == 0;
+}
+
+u32 platform_thread_get_id(void) {
+    return (u32)syscall(SYS_gettid);
+}
+
+void platform_thread_yield(void) {
+    sched_yield();
+}
+
+u32 platform_cpu_count(void) {
+    linux_cpu_init();
+    return linux_cpu_allowed_count;
+}
+
+void platform_futex_wait(volatile u32* address, u32 expected) {
+    syscall(SYS_futex, address, FUTEX_WAIT_PRIVATE, expected, null, null, 0);
+}
+
+void platform_futex_wake_one(volatile u32* address) {
+    syscall(SYS_futex, address, FUTEX_WAKE_PRIVATE, 1, null, null, 0);
+}
+
+void platform_futex_wake_all(volatile u32* address) {
+    syscall(SYS_futex, address, FUTEX_WAKE_PRIVATE, 0x7FFFFFFF, null, null, 0);
+}
+
 // FILE IO -------------------------------------------------------
 
 struct PlatformFile{
     int handle;
+    PlatformFile* next_free;
 };
 
+// File handles are carved out of pages from the platform allocator and
+// recycled through a free list instead of going through malloc
+internal PlatformFile* linux_file_alloc(void) {
+    nb_spin_lock(&linux_file_lock);
+    if (linux_file_free_list == null) {
+        usize page_size = platform_memory_get_page_size();
+        PlatformFile* files = platform_memory_reserve(page_size);
+        if (files == null) {
+            nb_spin_unlock(&linux_file_lock);
+            return null;
+        }
+        platform_memory_commit(files, page_size);
+
+        usize count = page_size / sizeof(PlatformFile);
+        for (usize i = 0; i < count; i++) {
+            files[i].next_free = (i + 1 < count) ? &files[i + 1] : null;
+        }
+        linux_file_free_list = files;
+    }
+    PlatformFile* pf = linux_file_free_list;
+    linux_file_free_list = pf->next_free;
+    nb_spin_unlock(&linux_file_lock);
+    return pf;
+}
+
+internal void linux_file_free(PlatformFile* pf) {
+    nb_spin_lock(&linux_file_lock);
+    pf->next_free = linux_file_free_list;
+    linux_file_free_list = pf;
+    nb_spin_unlock(&linux_file_lock);
+}
+
 PlatformFile* platform_file_open(const char* filepath) {
-    int fd = open(filepath, O_RDWR | O_CREAT, 0644);
+    return platform_file_open_ex(filepath, PLATFORM_FILE_OPEN_READ | PLATFORM_FILE_OPEN_WRITE);
+}
+
+PlatformFile* platform_file_open_ex(const char* filepath, u32 flags) {
+    b32 read = (flags & PLATFORM_FILE_OPEN_READ) != 0;
+    // Truncating needs write access, O_RDONLY | O_TRUNC is undefined
+    b32 write = (flags & (PLATFORM_FILE_OPEN_WRITE | PLATFORM_FILE_OPEN_APPEND | PLATFORM_FILE_OPEN_TRUNCATE)) != 0;
+
+    int open_flags = O_CLOEXEC;
+    if (read && write) {
+        open_flags |= O_RDWR;
+    } else if (write) {
+        open_flags |= O_WRONLY;
+    } else {
+        open_flags |= O_RDONLY;
+    }
+    if (write) {
+        open_flags |= O_CREAT;
+    }
+    if (flags & PLATFORM_FILE_OPEN_TRUNCATE) {
+        open_flags |= O_TRUNC;
+    }
+    if (flags & PLATFORM_FILE_OPEN_APPEND) {
+        open_flags |= O_APPEND;
+    }
+    if (flags & PLATFORM_FILE_OPEN_DIRECT) {
+        open_flags |= O_DIRECT;
+    }
+
+    int fd = open(filepath, open_flags, 0644);
     
     if (fd == -1) {
         return NULL;
     }
     
-    PlatformFile* pf = malloc(sizeof(PlatformFile));
+    PlatformFile* pf = linux_file_alloc();
+    if (pf == null) {
+        close(fd);
+        return NULL;
+    }
     pf->handle = fd;
     return pf;
 }
 
 usize platform_file_read(PlatformFile* f, void* buffer, usize size) {
-    ssize_t result = read(f->handle, buffer, size);
-    if (result < 0) {
-        return 0;
+    usize total = 0;
+    while (total < size) {
+        ssize_t result = read(f->handle, (u8*)buffer + total, size - total);
+        if (result < 0 && errno == EINTR) {
+            continue;
+        }
+        if (result <= 0) {
+            break;
+        }
+        total += (usize)result;
     }
-    return result; 
+    return total;
 }
 
 usize platform_file_write(PlatformFile* f, void* buffer, usize size) {
-    ssize_t result = write(f->handle, buffer, size);
-    if (result < 0) {
-        return 0;
+    usize total = 0;
+    while (total < size) {
+        ssize_t result = write(f->handle, (u8*)buffer + total, size - total);
+        if (result < 0 && errno == EINTR) {
+            continue;
+        }
+        if (result <= 0) {
+            break;
+        }
+        total += (usize)result;
+    }
+    return total;
+}
+
+usize platform_file_read_at(PlatformFile* f, void* buffer, usize size, u64 offset) {
+    usize total = 0;
+    while (total < size) {
+        ssize_t result = pread(f->handle, (u8*)buffer + total, size - total, (off_t)(offset + total));
+        if (result < 0 && errno == EINTR) {
+            continue;
+        }
+        if (result <= 0) {
+            break;
+        }
+        total += (usize)result;
+    }
+    return total;
+}
+
+usize platform_file_write_at(PlatformFile* f, void* buffer, usize size, u64 offset) {
+    usize total = 0;
+    while (total < size) {
+        ssize_t result = pwrite(f->handle, (u8*)buffer + total, size - total, (off_t)(offset + total));
+        if (result < 0 && errno == EINTR) {
+            continue;
+        }
+        if (result <= 0) {
+            break;
+        }
+        total += (usize)result;
+    }
+    return total;
+}
+
+b32 platform_file_advise(PlatformFile* f, u64 offset, u64 size, u32 access) {
+    int advice = POSIX_FADV_NORMAL;
+    switch (access) {
+        case PLATFORM_FILE_ACCESS_SEQUENTIAL: advice = POSIX_FADV_SEQUENTIAL; break;
+        case PLATFORM_FILE_ACCESS_RANDOM:     advice = POSIX_FADV_RANDOM; break;
+        case PLATFORM_FILE_ACCESS_WILL_NEED:  advice = POSIX_FADV_WILLNEED; break;
+        case PLATFORM_FILE_ACCESS_DONT_NEED:  advice = POSIX_FADV_DONTNEED; break;
     }
-    return result;
+    return posix_fadvise(f->handle, (off_t)offset, (off_t)size, advice) == 0;
 }
 
 b32 platform_file_close(PlatformFile* f) {
     int result = close(f->handle);
-    free(f);
+    linux_file_free(f);
     if (result != 0) {
         return false;
     }
@@ -104,10 +546,322 @@ b32 platform_file_exists(const char* filepath) {
     return false;
 }
 
+u64 platform_file_size(PlatformFile* f) {
+    struct stat st;
+    if (fstat(f->handle, &st) != 0) {
+        return 0;
+    }
+    return (u64)st.st_size;
+}
+
+b32 platform_file_map(PlatformFile* f, u32 flags, PlatformFileMapping* mapping) {
+    mapping->data = null;
+    mapping->size = 0;
+
+    u64 size = platform_file_size(f);
+    if (size == 0) {
+        return true;
+    }
+    if (size > (u64)(usize)-1) {
+        return false;
+    }
+
+    int protection = PROT_READ;
+    int map_flags = MAP_SHARED;
+    if (flags & PLATFORM_FILE_MAP_COPY_ON_WRITE) {
+        protection |= PROT_WRITE;
+        map_flags = MAP_PRIVATE;
+    }
+    void* data = mmap(null, (usize)size, protection, map_flags, f->handle, 0);
+    if (data == MAP_FAILED) {
+        return false;
+    }
+
+    if (flags & PLATFORM_FILE_MAP_SEQUENTIAL) {
+        madvise(data, (usize)size, MADV_SEQUENTIAL);
+    }
+    if (flags & PLATFORM_FILE_MAP_WILL_NEED) {
+        madvise(data, (usize)size, MADV_WILLNEED);
+    }
+
+    mapping->data = data;
+    mapping->size = (usize)size;
+    return true;
+}
+
+void platform_file_unmap(PlatformFileMapping* mapping) {
+    if (mapping->data != null) {
+        munmap(mapping->data, mapping->size);
+    }
+    mapping->data = null;
+    mapping->size = 0;
+}
+
+// ASYNC IO ------------------------------------------------------
+
+// io_uring through raw syscalls (https://kernel.dk/io_uring.pdf). The
+// submission and completion rings are shared with the kernel, we own the
+// SQ tail and the CQ head and publish them with release stores.
+struct PlatformIoQueue {
+    ThreadedIoQueue* threaded;
+
+    int ring_fd;
+    u32 sq_entries;
+    u32 sq_mask;
+    u32* sq_tail;
+    u32* sq_array;
+    struct io_uring_sqe* sqes;
+    u32 cq_mask;
+    u32* cq_head;
+    u32* cq_tail;
+    struct io_uring_cqe* cqes;
+
+    u32 in_flight;      // Submitted and not yet reaped, unsubmitted ones included
+    u32 unsubmitted;    // Queued SQEs the kernel hasn't taken yet
+
+    void* sq_ring;
+    usize sq_ring_size;
+    void* cq_ring;
+    usize cq_ring_size;
+    usize sqes_size;
+};
+
+internal i64 platform_io_execute(PlatformIoRequest* request) {
+    ssize_t result;
+    if (request->op == PLATFORM_IO_OP_READ) {
+        result = pread(request->file->handle, request->buffer, request->size, (off_t)request->offset);
+    } else {
+        result = pwrite(request->file->handle, request->buffer, request->size, (off_t)request->offset);
+    }
+    return result < 0 ? -(i64)errno : (i64)result;
+}
+
+internal PlatformIoQueue* linux_io_queue_alloc(void) {
+    usize size = sizeof(PlatformIoQueue);
+    PlatformIoQueue* queue = platform_memory_reserve(size);
+    if (queue != null) {
+        platform_memory_commit(queue, size);
+    }
+    return queue;
+}
+
+internal void linux_io_uring_unmap(PlatformIoQueue* queue) {
+    if (queue->sqes != null) {
+        munmap(queue->sqes, queue->sqes_size);
+    }
+    if (queue->cq_ring != null && queue->cq_ring != queue->sq_ring) {
+        munmap(queue->cq_ring, queue->cq_ring_size);
+    }
+    if (queue->sq_ring != null) {
+        munmap(queue->sq_ring, queue->sq_ring_size);
+    }
+}
+
+internal b32 linux_io_uring_init(PlatformIoQueue* queue, u32 depth) {
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    int fd = (int)syscall(__NR_io_uring_setup, depth, &params);
+    if (fd < 0) {
+        return false;
+    }
+    // IORING_OP_READ/WRITE arrived in 5.6 along with RW_CUR_POS, and NODROP
+    // means completions are never lost when the CQ is full
+    u32 required = IORING_FEAT_SINGLE_MMAP | IORING_FEAT_NODROP | IORING_FEAT_RW_CUR_POS;
+    if ((params.features & required) != required) {
+        close(fd);
+        return false;
+    }
+
+    queue->ring_fd = fd;
+    queue->sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(u32);
+    queue->cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    queue->sq_ring_size = NB_MAX(queue->sq_ring_size, queue->cq_ring_size);
+    queue->sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+
+    u8* ring = mmap(null, queue->sq_ring_size, PROT_READ | PROT_WRITE, 
+        MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+    if (ring == MAP_FAILED) {
+        close(fd);
+        return false;
+    }
+    queue->sq_ring = ring;
+    queue->cq_ring = ring;
+    queue->cq_ring_size = queue->sq_ring_size;
+
+    queue->sqes = mmap(null, queue->sqes_size, PROT_READ | PROT_WRITE, 
+        MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+    if (queue->sqes == MAP_FAILED) {
+        queue->sqes = null;
+        linux_io_uring_unmap(queue);
+        close(fd);
+        return false;
+    }
+
+    queue->sq_entries = params.sq_entries;
+    queue->sq_mask = *(u32*)(ring + params.sq_off.ring_mask);
+    queue->sq_tail = (u32*)(ring + params.sq_off.tail);
+    queue->sq_array = (u32*)(ring + params.sq_off.array);
+    queue->cq_mask = *(u32*)(ring + params.cq_off.ring_mask);
+    queue->cq_head = (u32*)(ring + params.cq_off.head);
+    queue->cq_tail = (u32*)(ring + params.cq_off.tail);
+    queue->cqes = (struct io_uring_cqe*)(ring + params.cq_off.cqes);
+    return true;
+}
+
+// Hands the queued SQEs to the kernel, optionally waiting for completions.
+// Returns 0 or the errno, SQEs the kernel refused stay queued for the next call.
+internal int linux_io_uring_enter(PlatformIoQueue* queue, u32 min_complete) {
+    u32 flags = min_complete ? IORING_ENTER_GETEVENTS : 0;
+    for (;;) {
+        long result = syscall(__NR_io_uring_enter, queue->ring_fd, queue->unsubmitted, 
+            min_complete, flags, null, 0);
+        if (result >= 0) {
+            queue->unsubmitted -= (u32)result;
+            return 0;
+        }
+        if (errno != EINTR) {
+            return errno;
+        }
+    }
+}
+
+// EBUSY (CQ overflow) and EAGAIN (out of kernel memory) clear up once
+// completions are reaped, other errors won't
+#define LINUX_IO_ENTER_RETRIES 8
+
+PlatformIoQueue* platform_io_queue_create(u32 depth, u32 flags) {
+    depth = NB_MAX(depth, 1);
+    if (depth > 4096) {
+        depth = 4096;
+    }
+    u32 rounded = 1;
+    while (rounded < depth) {
+        rounded *= 2;
+    }
+
+    PlatformIoQueue* queue = linux_io_queue_alloc();
+    if (queue == null) {
+        return null;
+    }
+    if (!(flags & PLATFORM_IO_QUEUE_FLAG_THREADED) && linux_io_uring_init(queue, rounded)) {
+        return queue;
+    }
+
+    queue->threaded = threaded_io_create(rounded);
+    if (queue->threaded == null) {
+        platform_memory_release(queue, sizeof(PlatformIoQueue));
+        return null;
+    }
+    return queue;
+}
+
+void platform_io_queue_destroy(PlatformIoQueue* queue) {
+    if (queue->threaded != null) {
+        threaded_io_destroy(queue->threaded);
+    } else {
+        // The kernel may still be writing into caller buffers
+        // SQEs it never took can just be dropped
+        PlatformIoCompletion completions[64];
+        while (queue->in_flight > queue->unsubmitted) {
+            if (platform_io_poll(queue, completions, 64, true) == 0) {
+                break;
+            }
+        }
+        linux_io_uring_unmap(queue);
+        close(queue->ring_fd);
+    }
+    platform_memory_release(queue, sizeof(PlatformIoQueue));
+}
+
+u32 platform_io_submit(PlatformIoQueue* queue, PlatformIoRequest* requests, u32 count) {
+    if (queue->threaded != null) {
+        return threaded_io_submit(queue->threaded, requests, count);
+    }
+
+    count = NB_MIN(count, queue->sq_entries - queue->in_flight);
+    u32 tail = *queue->sq_tail;
+    for (u32 i = 0; i < count; i++) {
+        PlatformIoRequest* request = &requests[i];
+        u32 index = tail & queue->sq_mask;
+        struct io_uring_sqe* sqe = &queue->sqes[index];
+        memset(sqe, 0, sizeof(*sqe));
+        sqe->opcode = request->op == PLATFORM_IO_OP_READ ? IORING_OP_READ : IORING_OP_WRITE;
+        sqe->fd = request->file->handle;
+        sqe->addr = (u64)(uptr)request->buffer;
+        sqe->len = request->size;
+        sqe->off = request->offset;
+        sqe->user_data = (u64)(uptr)request->user_data;
+        queue->sq_array[index] = index;
+        tail++;
+    }
+    nb_atomic_store_u32(queue->sq_tail, tail);
+
+    queue->in_flight += count;
+    queue->unsubmitted += count;
+    if (queue->unsubmitted > 0) {
+        linux_io_uring_enter(queue, 0);
+    }
+    return count;
+}
+
+u32 platform_io_poll(PlatformIoQueue* queue, PlatformIoCompletion* completions, u32 max, b32 wait) {
+    if (queue->threaded != null) {
+        return threaded_io_poll(queue->threaded, completions, max, wait);
+    }
+
+    u32 attempts = 0;
+    for (;;) {
+        u32 head = *queue->cq_head;
+        u32 tail = nb_atomic_load_u32(queue->cq_tail);
+        u32 count = 0;
+        while (count < max && head != tail) {
+            struct io_uring_cqe* cqe = &queue->cqes[head & queue->cq_mask];
+            completions[count].user_data = (void*)(uptr)cqe->user_data;
+            completions[count].result = cqe->res;
+            count++;
+            head++;
+        }
+        nb_atomic_store_u32(queue->cq_head, head);
+        queue->in_flight -= count;
+
+        if (count > 0 || !wait || queue->in_flight == 0 || max == 0) {
+            if (queue->unsubmitted > 0) {
+                linux_io_uring_enter(queue, 0);
+            }
+            return count;
+        }
+
+        // Only wait on requests the kernel has actually taken
+        int error = 0;
+        if (queue->in_flight == queue->unsubmitted) {
+            error = linux_io_uring_enter(queue, 0);
+        }
+        if (error == 0 && queue->in_flight > queue->unsubmitted) {
+            error = linux_io_uring_enter(queue, 1);
+        } else if (error == 0) {
+            error = EAGAIN;
+        }
+        if (error != 0) {
+            b32 transient = error == EBUSY || error == EAGAIN;
+            if (!transient || ++attempts >= LINUX_IO_ENTER_RETRIES) {
+                return 0;
+            }
+            platform_thread_yield();
+        }
+    }
+}
+
+u32 platform_io_in_flight(PlatformIoQueue* queue) {
+    if (queue->threaded != null) {
+        return threaded_io_in_flight(queue->threaded);
+    }
+    return queue->in_flight;
+}
+
 // TIMING --------------------------------------------------------
 
 internal void linux_time_init(void) {
-    clock_gettime(CLOCK_MONOTONIC, &linux_time_start);
+    linux_time_start = platform_time_get_ticks();
     linux_time_initialized = true;
 }
 
@@ -122,17 +876,61 @@ f64 platform_time_get_seconds(void) {
         linux_time_init();
     }
 
-    struct timespec now;
-    clock_gettime(CLOCK_MONOTONIC, &now);
+    // Subtracting whole nanosecond counts avoids borrowing between the
+    // seconds and nanoseconds fields
+    u64 elapsed = platform_time_get_ticks() - linux_time_start;
+    return (f64)elapsed / 1000000000.0;
+}
+
+u64 platform_time_get_cycles(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    return __builtin_ia32_rdtsc();
+#elif defined(__aarch64__)
+    u64 value;
+    __asm__ __volatile__("mrs %0, cntvct_el0" : "=r"(value));
+    return value;
+#else
+    return platform_time_get_ticks();
+#endif
+}
 
-    u64 elapsed_sec = now.tv_sec - linux_time_start.tv_sec;
-    u64 elapsed_nsec = now.tv_nsec - linux_time_start.tv_nsec;
+internal u64 linux_time_calibrate_cycles(void) {
+#if defined(__aarch64__)
+    u64 frequency;
+    __asm__ __volatile__("mrs %0, cntfrq_el0" : "=r"(frequency));
+    return frequency;
+#elif defined(__x86_64__) || defined(__i386__)
+    // Spin rather than sleep so the measurement isn't at the scheduler's mercy
+    u64 ticks_start = platform_time_get_ticks();
+    u64 cycles_start = platform_time_get_cycles();
+    u64 ticks_end;
+    do {
+        ticks_end = platform_time_get_ticks();
+    } while (ticks_end - ticks_start < 10000000ULL);
+    u64 cycles_end = platform_time_get_cycles();
+    return (u64)((f64)(cycles_end - cycles_start) * 1000000000.0 / (f64)(ticks_end - ticks_start));
+#else
+    return 1000000000ULL;
+#endif
+}
 
-    f64 result = (f64)elapsed_sec + (f64)elapsed_nsec / 1000000000.0;
-    
-    return result;
+u64 platform_time_get_cycle_frequency(void) {
+    // Racing threads both calibrate and store close enough values
+    u64 frequency = nb_atomic_load_u64(&linux_time_cycle_frequency);
+    if (frequency == 0) {
+        frequency = linux_time_calibrate_cycles();
+        nb_atomic_store_u64(&linux_time_cycle_frequency, frequency);
+    }
+    return frequency;
 }
 
+f64 platform_time_cycles_to_seconds(u64 cycles) {
+    return (f64)cycles / (f64)platform_time_get_cycle_frequency();
+}
+
+u64 platform_time_cycles_to_nanoseconds(u64 cycles) {
+    return (u64)((f64)cycles * 1000000000.0 / (f64)platform_time_get_cycle_frequency());
+}
 
 void platform_time_sleep(u32 ms) {
     usleep(ms * 1000);
@@ -6,12 +6,38 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <stdarg.h>
+#include <string.h>
+
+// WaitOnAddress and WakeByAddress*
+#pragma comment(lib, "synchronization.lib")
 
 // GLOBALS --------------------------------------------------
 
 global LARGE_INTEGER win32_time_perf_frequency;
 global LARGE_INTEGER win32_time_perf_start;
 global b32           win32_time_initialized = false;
+global volatile u64  win32_time_cycle_frequency = 0;
+
+// Allowed processors per group, read once
+#define WIN32_MAX_PROCESSOR_GROUPS 64
+global KAFFINITY     win32_cpu_group_masks[WIN32_MAX_PROCESSOR_GROUPS];
+global u32           win32_cpu_allowed_count = 0;
+global volatile u32  win32_cpu_state = 0; // 0 unread, 1 reading, 2 ready
+
+global PlatformFile* win32_file_free_list = null;
+global volatile u32  win32_file_lock = 0;
+
+// MEM_LARGE_PAGES ranges are committed for their whole lifetime and can't be
+// committed or decommitted piecewise, those calls skip them
+#define WIN32_MAX_LARGE_PAGE_RANGES 64
+typedef struct Win32LargePageRange {
+    u8* base;
+    usize size;
+} Win32LargePageRange;
+
+global Win32LargePageRange win32_large_page_ranges[WIN32_MAX_LARGE_PAGE_RANGES];
+global u32                 win32_large_page_range_count = 0;
+global volatile u32        win32_large_page_lock = 0;
 
 // MEMORY ---------------------------------------------------
 
@@ -31,20 +57,97 @@ internal DWORD win32_memory_map_protection(u32 flags)  {
     return 0;
 }
 
+internal b32 win32_memory_is_large_page(void* ptr) {
+    b32 found = false;
+    nb_spin_lock(&win32_large_page_lock);
+    for (u32 i = 0; i < win32_large_page_range_count; i++) {
+        Win32LargePageRange* range = &win32_large_page_ranges[i];
+        if ((u8*)ptr >= range->base && (u8*)ptr < range->base + range->size) {
+            found = true;
+            break;
+        }
+    }
+    nb_spin_unlock(&win32_large_page_lock);
+    return found;
+}
+
+internal b32 win32_memory_track_large_page(void* ptr, usize size) {
+    b32 tracked = false;
+    nb_spin_lock(&win32_large_page_lock);
+    if (win32_large_page_range_count < WIN32_MAX_LARGE_PAGE_RANGES) {
+        Win32LargePageRange* range = &win32_large_page_ranges[win32_large_page_range_count++];
+        range->base = ptr;
+        range->size = size;
+        tracked = true;
+    }
+    nb_spin_unlock(&win32_large_page_lock);
+    return tracked;
+}
+
+internal void win32_memory_untrack_large_page(void* ptr) {
+    nb_spin_lock(&win32_large_page_lock);
+    for (u32 i = 0; i < win32_large_page_range_count; i++) {
+        if (win32_large_page_ranges[i].base == ptr) {
+            win32_large_page_ranges[i] = win32_large_page_ranges[--win32_large_page_range_count];
+            break;
+        }
+    }
+    nb_spin_unlock(&win32_large_page_lock);
+}
+
 void* platform_memory_reserve(usize size) {
     void* ptr = VirtualAlloc(null, size, MEM_RESERVE, PAGE_NOACCESS);
     return ptr;
 }
 
+void* platform_memory_reserve_ex(usize size, u32 flags) {
+    if (flags & PLATFORM_MEMORY_FLAG_LARGE_PAGES) {
+        // Large pages can't be committed lazily and need SeLockMemoryPrivilege,
+        // fall back to regular pages when the allocation is refused
+        usize large_page_size = platform_memory_get_large_page_size();
+        usize actual_size = (size + large_page_size - 1) & ~(large_page_size - 1);
+        void* ptr = VirtualAlloc(null, actual_size, 
+            MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE);
+        if (ptr && win32_memory_track_large_page(ptr, actual_size)) {
+            return ptr;
+        }
+        if (ptr) {
+            VirtualFree(ptr, 0, MEM_RELEASE);
+        }
+    }
+
+    // Windows has no transparent huge pages
+    return platform_memory_reserve(size);
+}
+
 void platform_memory_commit(void* ptr, usize size) {
+    if (win32_memory_is_large_page(ptr)) {
+        return;
+    }
     VirtualAlloc(ptr, size, MEM_COMMIT, PAGE_READWRITE);
 }
 
+void platform_memory_commit_ex(void* ptr, usize size, u32 flags) {
+    platform_memory_commit(ptr, size);
+
+    if (flags & PLATFORM_MEMORY_FLAG_PREFAULT) {
+        usize page_size = platform_memory_get_page_size();
+        for (usize offset = 0; offset < size; offset += page_size) {
+            volatile u8* page = (volatile u8*)ptr + offset;
+            *page = *page;
+        }
+    }
+}
+
 void platform_memory_decommit(void* ptr, usize size) {
+    if (win32_memory_is_large_page(ptr)) {
+        return;
+    }
     VirtualFree(ptr, size, MEM_DECOMMIT);
 }
 
 void platform_memory_release(void* ptr, usize size) {
+    win32_memory_untrack_large_page(ptr);
     VirtualFree(ptr, 0, MEM_RELEASE);
 }
 
@@ -60,75 +163,495 @@ usize platform_memory_get_page_size(void) {
     return (usize)info.dwPageSize;
 }
 
+usize platform_memory_get_large_page_size(void) {
+    usize size = (usize)GetLargePageMinimum();
+    return size ? size : 2 * 1024 * 1024;
+}
+
+// NUMA ----------------------------------------------------------
+
+u32 platform_numa_node_count(void) {
+    ULONG highest = 0;
+    if (!GetNumaHighestNodeNumber(&highest)) {
+        return 1;
+    }
+    return (u32)highest + 1;
+}
+
+u32 platform_numa_current_node(void) {
+    PROCESSOR_NUMBER processor;
+    USHORT node = 0;
+    GetCurrentProcessorNumberEx(&processor);
+    if (!GetNumaProcessorNodeEx(&processor, &node)) {
+        return 0;
+    }
+    return (u32)node;
+}
+
+b32 platform_memory_bind_node(void* ptr, usize size, u32 node) {
+    // Windows only takes a preferred node when memory is allocated
+    // (VirtualAllocExNuma), an existing reservation falls back to first touch
+    (void)ptr;
+    (void)size;
+    return platform_numa_node_count() <= 1 && node == 0;
+}
+
+b32 platform_numa_set_thread_node(u32 node) {
+    if (platform_numa_node_count() <= 1) {
+        return true;
+    }
+
+    // Windows places pages on the node of the faulting thread, so pin the
+    // thread to the node's processors
+    GROUP_AFFINITY affinity;
+    if (!GetNumaNodeProcessorMaskEx((USHORT)node, &affinity)) {
+        return false;
+    }
+    return SetThreadGroupAffinity(GetCurrentThread(), &affinity, null) != 0;
+}
+
+// THREADS ------------------------------------------------------
+
+internal DWORD WINAPI win32_thread_proc(LPVOID data) {
+    PlatformThread* thread = data;
+    thread->proc(thread->data);
+    return 0;
+}
+
+b32 platform_thread_create(PlatformThread* thread, PlatformThreadProc proc, void* data) {
+    thread->proc = proc;
+    thread->data = data;
+    HANDLE handle = CreateThread(null, 0, win32_thread_proc, thread, 0, null);
+    if (handle == null) {
+        return false;
+    }
+    thread->handle = (u64)(uptr)handle;
+    return true;
+}
+
+void platform_thread_join(PlatformThread* thread) {
+    HANDLE handle = (HANDLE)(uptr)thread->handle;
+    WaitForSingleObject(handle, INFINITE);
+    CloseHandle(handle);
+}
+
+internal u32 win32_count_bits(KAFFINITY mask) {
+    u32 count = 0;
+    while (mask) {
+        mask &= mask - 1;
+        count++;
+    }
+    return count;
+}
+
+internal KAFFINITY win32_group_all_processors(WORD group) {
+    DWORD count = GetActiveProcessorCount(group);
+    return count >= 64 ? ~(KAFFINITY)0 : (((KAFFINITY)1 << count) - 1);
+}
+
+// A process limited to one group has an affinity mask there, one spanning
+// several groups may use every processor of them
+internal void win32_cpu_init(void) {
+    if (nb_atomic_load_u32(&win32_cpu_state) == 2) {
+        return;
+    }
+    if (!nb_atomic_cas_u32(&win32_cpu_state, 0, 1)) {
+        while (nb_atomic_load_u32(&win32_cpu_state) != 2) {
+            NB_CPU_PAUSE();
+        }
+        return;
+    }
+
+    USHORT groups[WIN32_MAX_PROCESSOR_GROUPS];
+    USHORT group_count = WIN32_MAX_PROCESSOR_GROUPS;
+    DWORD_PTR process_mask = 0, system_mask = 0;
+    if (!GetProcessGroupAffinity(GetCurrentProcess(), &group_count, groups)) {
+        group_count = 0;
+    }
+    if (group_count == 1 && GetProcessAffinityMask(GetCurrentProcess(), &process_mask, &system_mask)) {
+        win32_cpu_group_masks[groups[0]] = (KAFFINITY)process_mask;
+    } else if (group_count > 0) {
+        for (USHORT i = 0; i < group_count; i++) {
+            win32_cpu_group_masks[groups[i]] = win32_group_all_processors(groups[i]);
+        }
+    } else {
+        WORD active_groups = GetActiveProcessorGroupCount();
+        for (WORD group = 0; group < active_groups && group < WIN32_MAX_PROCESSOR_GROUPS; group++) {
+            win32_cpu_group_masks[group] = win32_group_all_processors(group);
+        }
+    }
+
+    u32 count = 0;
+    for (u32 group = 0; group < WIN32_MAX_PROCESSOR_GROUPS; group++) {
+        count += win32_count_bits(win32_cpu_group_masks[group]);
+    }
+    win32_cpu_allowed_count = count > 0 ? count : 1;
+    nb_atomic_store_u32(&win32_cpu_state, 2);
+}
+
+b32 platform_thread_set_affinity(u32 cpu) {
+    win32_cpu_init();
+    // CPUs are numbered across processor groups, skipping disallowed ones
+    for (WORD group = 0; group < WIN32_MAX_PROCESSOR_GROUPS; group++) {
+        KAFFINITY mask = win32_cpu_group_masks[group];
+        u32 bits = win32_count_bits(mask);
+        if (cpu >= bits) {
+            cpu -= bits;
+            continue;
+        }
+        for (u32 i = 0; i < cpu; i++) {
+            mask &= mask - 1;
+        }
+        GROUP_AFFINITY affinity = {0};
+        affinity.Group = group;
+        affinity.Mask = mask & (~mask + 1);
+        return SetThreadGroupAffinity(GetCurrentThread(), &affinity, null) != 0;
+    }
+    return false;
+}
+
+b32 platform_thread_save_affinity(PlatformAffinity* affinity) {
+    memset(affinity, 0, sizeof(PlatformAffinity));
+    return GetThreadGroupAffinity(GetCurrentThread(), (GROUP_AFFINITY*)affinity->data) != 0;
+}
+
+b32 platform_thread_restore_affinity(const PlatformAffinity* affinity) {
+    return SetThreadGroupAffinity(GetCurrentThread(), (const GROUP_AFFINITY*)affinity->data, null) != 0;
+}
+
+u32 platform_thread_get_id(void) {
+    return (u32)GetCurrentThreadId();
+}
+
+void platform_thread_yield(void) {
+    SwitchToThread();
+}
+
+u32 platform_cpu_count(void) {
+    win32_cpu_init();
+    return win32_cpu_allowed_count;
+}
+
+void platform_futex_wait(volatile u32* address, u32 expected) {
+    WaitOnAddress(address, &expected, sizeof(u32), INFINITE);
+}
+
+void platform_futex_wake_one(volatile u32* address) {
+    WakeByAddressSingle((PVOID)address);
+}
+
+void platform_futex_wake_all(volatile u32* address) {
+    WakeByAddressAll((PVOID)address);
+}
+
 // FILE IO --------------------------------------------------------------------------------
 
+// Every ReadFile/WriteFile passes an OVERLAPPED offset and moves the Win32
+// file pointer, so sequential IO tracks its own position instead of relying
+// on it. That keeps the positional calls from disturbing it, as on Linux.
 struct PlatformFile {
     HANDLE handle;
+    u64 position;
+    b32 append;
+    PlatformFile* next_free;
 };
 
-internal wchar_t* win32_utf8_to_utf16(const char *utf8) {
-    int count = MultiByteToWideChar(CP_UTF8, MB_ERR_INVALID_CHARS, utf8, -1, NULL, 0);
-    NB_ASSERT(count != 0);
+#define WIN32_MAX_PATH 4096
+
+// Fails on invalid UTF-8 or when 'wide' is too small, callers report it
+internal b32 win32_utf8_to_utf16(const char *utf8, wchar_t* wide, int wide_count) {
+    int count = MultiByteToWideChar(CP_UTF8, MB_ERR_INVALID_CHARS, utf8, -1, wide, wide_count);
+    return count != 0;
+}
 
-    wchar_t* wide = (wchar_t*)malloc(count * sizeof(wchar_t));
-    MultiByteToWideChar(CP_UTF8, 0, utf8, -1, wide, count);
+// File handles are carved out of pages from the platform allocator and
+// recycled through a free list instead of going through malloc
+internal PlatformFile* win32_file_alloc(void) {
+    nb_spin_lock(&win32_file_lock);
+    if (win32_file_free_list == null) {
+        usize page_size = platform_memory_get_page_size();
+        PlatformFile* files = platform_memory_reserve(page_size);
+        if (files == null) {
+            nb_spin_unlock(&win32_file_lock);
+            return null;
+        }
+        platform_memory_commit(files, page_size);
+
+        usize count = page_size / sizeof(PlatformFile);
+        for (usize i = 0; i < count; i++) {
+            files[i].next_free = (i + 1 < count) ? &files[i + 1] : null;
+        }
+        win32_file_free_list = files;
+    }
+    PlatformFile* file = win32_file_free_list;
+    win32_file_free_list = file->next_free;
+    nb_spin_unlock(&win32_file_lock);
+    return file;
+}
 
-    return wide;
+internal void win32_file_free(PlatformFile* file) {
+    nb_spin_lock(&win32_file_lock);
+    file->next_free = win32_file_free_list;
+    win32_file_free_list = file;
+    nb_spin_unlock(&win32_file_lock);
 }
 
 PlatformFile* platform_file_open(const char* filepath) {
-    wchar_t *wide_path = win32_utf8_to_utf16(filepath);
+    return platform_file_open_ex(filepath, PLATFORM_FILE_OPEN_READ | PLATFORM_FILE_OPEN_WRITE);
+}
+
+PlatformFile* platform_file_open_ex(const char* filepath, u32 flags) {
+    wchar_t wide_path[WIN32_MAX_PATH];
+    if (!win32_utf8_to_utf16(filepath, wide_path, WIN32_MAX_PATH)) {
+        return NULL;
+    }
+
+    // Truncating needs write access, TRUNCATE_EXISTING fails with GENERIC_READ only
+    b32 write = (flags & (PLATFORM_FILE_OPEN_WRITE | PLATFORM_FILE_OPEN_APPEND | PLATFORM_FILE_OPEN_TRUNCATE)) != 0;
+    DWORD access = 0;
+    if (flags & PLATFORM_FILE_OPEN_READ) {
+        access |= GENERIC_READ;
+    }
+    if (flags & PLATFORM_FILE_OPEN_APPEND) {
+        // Without FILE_WRITE_DATA every write lands at the end of the file
+        access |= FILE_APPEND_DATA | SYNCHRONIZE;
+    } else if (write) {
+        access |= GENERIC_WRITE;
+    }
+
+    DWORD disposition = OPEN_EXISTING;
+    if (write) {
+        disposition = (flags & PLATFORM_FILE_OPEN_TRUNCATE) ? CREATE_ALWAYS : OPEN_ALWAYS;
+    }
+
+    DWORD attributes = FILE_ATTRIBUTE_NORMAL;
+    if (flags & PLATFORM_FILE_OPEN_DIRECT) {
+        attributes |= FILE_FLAG_NO_BUFFERING | FILE_FLAG_WRITE_THROUGH;
+    }
 
     HANDLE h = CreateFileW(
         wide_path, 
-        GENERIC_READ | GENERIC_WRITE, 
+        access, 
         FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
         null,
-        OPEN_ALWAYS,
-        FILE_ATTRIBUTE_NORMAL,
+        disposition,
+        attributes,
         null);
 
-    free(wide_path);
-
     if (h == INVALID_HANDLE_VALUE) {
         return NULL;
     }
 
-    PlatformFile *file = malloc(sizeof(PlatformFile));
+    PlatformFile *file = win32_file_alloc();
+    if (file == null) {
+        CloseHandle(h);
+        return NULL;
+    }
     file->handle = h;
+    file->position = 0;
+    file->append = (flags & PLATFORM_FILE_OPEN_APPEND) != 0;
 
     return file;
 }
 
+// ReadFile and WriteFile take a DWORD size, larger requests go in chunks
+#define WIN32_FILE_CHUNK_SIZE ((usize)1 << 30)
+
+internal usize win32_file_transfer(PlatformFile* f, void* buffer, usize size, u64 offset, b32 write) {
+    usize total = 0;
+    while (total < size) {
+        u64 position = offset + total;
+        OVERLAPPED overlapped = {0};
+        overlapped.Offset = (DWORD)position;
+        overlapped.OffsetHigh = (DWORD)(position >> 32);
+        if (write && f->append) {
+            // All ones writes at the end of the file
+            overlapped.Offset = 0xFFFFFFFF;
+            overlapped.OffsetHigh = 0xFFFFFFFF;
+        }
+        DWORD chunk = (DWORD)NB_MIN(size - total, WIN32_FILE_CHUNK_SIZE);
+        DWORD result = 0;
+        BOOL ok = write
+            ? WriteFile(f->handle, (u8*)buffer + total, chunk, &result, &overlapped)
+            : ReadFile(f->handle, (u8*)buffer + total, chunk, &result, &overlapped);
+        if (!ok || result == 0) {
+            break;
+        }
+        total += result;
+    }
+    return total;
+}
+
 usize platform_file_read(PlatformFile* f, void* buffer, usize size) {
-    DWORD result;
-    ReadFile(f->handle, buffer, size, &result, null);
+    usize result = win32_file_transfer(f, buffer, size, f->position, false);
+    f->position += result;
     return result;
 }
 
 usize platform_file_write(PlatformFile* f, void* buffer, usize size) {
-    DWORD result;
-    WriteFile(f->handle, buffer, size, &result, null);
+    usize result = win32_file_transfer(f, buffer, size, f->position, true);
+    f->position += result;
     return result;
 }
 
+usize platform_file_read_at(PlatformFile* f, void* buffer, usize size, u64 offset) {
+    return win32_file_transfer(f, buffer, size, offset, false);
+}
+
+usize platform_file_write_at(PlatformFile* f, void* buffer, usize size, u64 offset) {
+    return win32_file_transfer(f, buffer, size, offset, true);
+}
+
+b32 platform_file_advise(PlatformFile* f, u64 offset, u64 size, u32 access) {
+    // Windows only takes access hints at open time (FILE_FLAG_SEQUENTIAL_SCAN)
+    (void)f;
+    (void)offset;
+    (void)size;
+    (void)access;
+    return true;
+}
+
 b32 platform_file_close(PlatformFile* f) {
     b32 result = CloseHandle(f->handle);
     if (result) {
-        free(f);
+        win32_file_free(f);
     }
 
     return result;
 }
 
 b32 platform_file_exists(const char* filepath) {
-    wchar_t *wide_path = win32_utf8_to_utf16(filepath);
+    wchar_t wide_path[WIN32_MAX_PATH];
+    if (!win32_utf8_to_utf16(filepath, wide_path, WIN32_MAX_PATH)) {
+        return false;
+    }
     DWORD attribs = GetFileAttributesW(wide_path);
-    free(wide_path);
 
     return (attribs != INVALID_FILE_ATTRIBUTES);
 }
 
+u64 platform_file_size(PlatformFile* f) {
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(f->handle, &size)) {
+        return 0;
+    }
+    return (u64)size.QuadPart;
+}
+
+b32 platform_file_map(PlatformFile* f, u32 flags, PlatformFileMapping* mapping) {
+    mapping->data = null;
+    mapping->size = 0;
+
+    u64 size = platform_file_size(f);
+    if (size == 0) {
+        return true;
+    }
+    if (size > (u64)(usize)-1) {
+        return false;
+    }
+
+    b32 copy_on_write = (flags & PLATFORM_FILE_MAP_COPY_ON_WRITE) != 0;
+    HANDLE section = CreateFileMappingW(f->handle, null, 
+        copy_on_write ? PAGE_WRITECOPY : PAGE_READONLY, 0, 0, null);
+    if (section == null) {
+        return false;
+    }
+    // The view keeps the section alive on its own
+    void* data = MapViewOfFile(section, copy_on_write ? FILE_MAP_COPY : FILE_MAP_READ, 0, 0, 0);
+    CloseHandle(section);
+    if (data == null) {
+        return false;
+    }
+
+    // Windows has no sequential hint for views, the cache manager detects it
+    if (flags & PLATFORM_FILE_MAP_WILL_NEED) {
+        WIN32_MEMORY_RANGE_ENTRY range;
+        range.VirtualAddress = data;
+        range.NumberOfBytes = (SIZE_T)size;
+        PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+    }
+
+    mapping->data = data;
+    mapping->size = (usize)size;
+    return true;
+}
+
+void platform_file_unmap(PlatformFileMapping* mapping) {
+    if (mapping->data != null) {
+        UnmapViewOfFile(mapping->data);
+    }
+    mapping->data = null;
+    mapping->size = 0;
+}
+
+// ASYNC IO ------------------------------------------------------
+
+// Files are opened without FILE_FLAG_OVERLAPPED so the queue always runs on
+// the thread pool from platform_io_threaded.c
+struct PlatformIoQueue {
+    ThreadedIoQueue* threaded;
+};
+
+internal i64 platform_io_execute(PlatformIoRequest* request) {
+    OVERLAPPED overlapped = {0};
+    overlapped.Offset = (DWORD)request->offset;
+    overlapped.OffsetHigh = (DWORD)(request->offset >> 32);
+    DWORD transferred = 0;
+    BOOL ok;
+    if (request->op == PLATFORM_IO_OP_READ) {
+        ok = ReadFile(request->file->handle, request->buffer, request->size, &transferred, &overlapped);
+    } else {
+        ok = WriteFile(request->file->handle, request->buffer, request->size, &transferred, &overlapped);
+    }
+    if (!ok) {
+        DWORD error = GetLastError();
+        // Reading at or past the end is a short read, not a failure
+        return error == ERROR_HANDLE_EOF ? 0 : -(i64)error;
+    }
+    return (i64)transferred;
+}
+
+PlatformIoQueue* platform_io_queue_create(u32 depth, u32 flags) {
+    (void)flags;
+    depth = NB_MAX(depth, 1);
+    if (depth > 4096) {
+        depth = 4096;
+    }
+    u32 rounded = 1;
+    while (rounded < depth) {
+        rounded *= 2;
+    }
+
+    PlatformIoQueue* queue = platform_memory_reserve(sizeof(PlatformIoQueue));
+    if (queue == null) {
+        return null;
+    }
+    platform_memory_commit(queue, sizeof(PlatformIoQueue));
+    queue->threaded = threaded_io_create(rounded);
+    if (queue->threaded == null) {
+        platform_memory_release(queue, sizeof(PlatformIoQueue));
+        return null;
+    }
+    return queue;
+}
+
+void platform_io_queue_destroy(PlatformIoQueue* queue) {
+    threaded_io_destroy(queue->threaded);
+    platform_memory_release(queue, sizeof(PlatformIoQueue));
+}
+
+u32 platform_io_submit(PlatformIoQueue* queue, PlatformIoRequest* requests, u32 count) {
+    return threaded_io_submit(queue->threaded, requests, count);
+}
+
+u32 platform_io_poll(PlatformIoQueue* queue, PlatformIoCompletion* completions, u32 max, b32 wait) {
+    return threaded_io_poll(queue->threaded, completions, max, wait);
+}
+
+u32 platform_io_in_flight(PlatformIoQueue* queue) {
+    return threaded_io_in_flight(queue->threaded);
+}
+
 // TIMING --------------------------------------------------------
 
 internal void win32_time_init(void) {
@@ -157,6 +680,52 @@ f64 platform_time_get_seconds(void) {
     return result;
 }
 
+u64 platform_time_get_cycles(void) {
+#if defined(_M_X64) || defined(_M_IX86)
+    return __rdtsc();
+#else
+    // QPC reads the generic timer directly on ARM64
+    return platform_time_get_ticks();
+#endif
+}
+
+internal u64 win32_time_calibrate_cycles(void) {
+    LARGE_INTEGER frequency;
+    QueryPerformanceFrequency(&frequency);
+#if defined(_M_X64) || defined(_M_IX86)
+    // Spin rather than sleep so the measurement isn't at the scheduler's mercy
+    u64 ticks_start = platform_time_get_ticks();
+    u64 cycles_start = platform_time_get_cycles();
+    u64 ticks_wait = (u64)frequency.QuadPart / 100;
+    u64 ticks_end;
+    do {
+        ticks_end = platform_time_get_ticks();
+    } while (ticks_end - ticks_start < ticks_wait);
+    u64 cycles_end = platform_time_get_cycles();
+    return (u64)((f64)(cycles_end - cycles_start) * (f64)frequency.QuadPart / (f64)(ticks_end - ticks_start));
+#else
+    return (u64)frequency.QuadPart;
+#endif
+}
+
+u64 platform_time_get_cycle_frequency(void) {
+    // Racing threads both calibrate and store close enough values
+    u64 frequency = nb_atomic_load_u64(&win32_time_cycle_frequency);
+    if (frequency == 0) {
+        frequency = win32_time_calibrate_cycles();
+        nb_atomic_store_u64(&win32_time_cycle_frequency, frequency);
+    }
+    return frequency;
+}
+
+f64 platform_time_cycles_to_seconds(u64 cycles) {
+    return (f64)cycles / (f64)platform_time_get_cycle_frequency();
+}
+
+u64 platform_time_cycles_to_nanoseconds(u64 cycles) {
+    return (u64)((f64)cycles * 1000000000.0 / (f64)platform_time_get_cycle_frequency());
+}
+
 void platform_time_sleep(u32 ms) {
     Sleep(ms);
 }